@@ -1,7 +1,18 @@
 #pragma once
 #include "types.h"
+#include <SDL3/SDL_atomic.h>
 
 struct emp_generated_assets_o;
+struct emp_package_t;
+
+typedef enum emp_asset_state_t
+{
+	EMP_ASSET_UNLOADED,
+	EMP_ASSET_LOADING,
+	// `load` has run on a loader thread; `finish` has not.
+	EMP_ASSET_DECODED,
+	EMP_ASSET_LOADED,
+} emp_asset_state_t;
 
 typedef struct emp_asset_t
 {
@@ -11,12 +22,23 @@ typedef struct emp_asset_t
 	u64 hash;
 	void* handle;
 	i64 last_modified;
+	// emp_asset_state_t. `handle` may only be read once this is EMP_ASSET_LOADED.
+	SDL_AtomicInt state;
+	// Import data Florence generates for the type, such as the
+	// emp_atlas_region_t of a PNG. NULL when the type has none.
+	const void* meta;
+	// Set in packaged builds; `data` is filled from the package on first load.
+	struct emp_package_t* package;
+	u32 package_index;
 } emp_asset_t;
 
 typedef struct emp_asset_loader_t
 {
+	// Runs on a loader thread, so it must not touch the renderer.
 	void (*load)(emp_asset_t* asset);
 	void (*unload)(emp_asset_t* asset);
+	// Optional. Runs on the main thread after `load`, for GPU uploads.
+	void (*finish)(emp_asset_t* asset);
 } emp_asset_loader_t;
 
 typedef struct emp_asset_type_t
@@ -38,15 +60,43 @@ typedef struct emp_asset_by_path_t
 	emp_asset_t* value;
 } emp_asset_by_path_t;
 
+struct emp_asset_watcher_t;
+struct emp_asset_loading_t;
+
 typedef struct emp_asset_manager_o
 {
 	emp_asset_kvp* assets_by_ext;
 	emp_asset_by_path_t* assets_by_path;
-	float accumulator;
+	struct emp_asset_watcher_t* watcher;
+	struct emp_asset_loading_t* loading;
 } emp_asset_manager_o;
 
 emp_asset_manager_o* emp_asset_manager_create(struct emp_generated_assets_o* assets);
+void emp_asset_manager_destroy(emp_asset_manager_o* mgr);
 
 void emp_asset_manager_add_loader(emp_asset_manager_o* mgr, emp_asset_loader_t loader, u64 type);
 
-void emp_asset_manager_check_hot_reload(emp_asset_manager_o* mgr, float dt);
+// Queues every unloaded asset that has a loader onto loader threads, one
+// per core, and returns without waiting.
+void emp_asset_manager_load_async(emp_asset_manager_o* mgr);
+// Runs `finish` for the assets decoded since the last call.
+void emp_asset_manager_finish_loads(emp_asset_manager_o* mgr);
+// Blocks until `asset` is loaded, helping decode queued assets meanwhile.
+void emp_asset_manager_wait(emp_asset_manager_o* mgr, emp_asset_t* asset);
+void emp_asset_manager_wait_type(emp_asset_manager_o* mgr, u64 type);
+// emp_asset_manager_load_async, then waits for every asset.
+void emp_asset_manager_load_all(emp_asset_manager_o* mgr);
+
+static inline bool emp_asset_is_loaded(emp_asset_t* asset)
+{
+	return SDL_GetAtomicInt(&asset->state) == EMP_ASSET_LOADED;
+}
+
+// Starts a thread that watches the asset files (inotify on Linux, polling
+// elsewhere) and reads and hashes the ones that change. Does nothing when
+// assets are packaged.
+void emp_asset_manager_watch(emp_asset_manager_o* mgr);
+
+// Swaps in the files the watcher has read since the last call. Only checks
+// an atomic when nothing changed.
+void emp_asset_manager_check_hot_reload(emp_asset_manager_o* mgr);
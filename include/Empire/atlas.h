@@ -0,0 +1,69 @@
+#pragma once
+#include "types.h"
+
+// Florence packs every PNG onto a few atlas pages at build time and gives
+// each one an emp_atlas_region_t (the asset's `meta`): where it sits on its
+// page and how it splits into animation frames. Pages are assembled at load
+// time. Each PNG is decoded on a loader thread and copied onto its page on
+// the main thread, with its edge texels repeated into the padding so nearest
+// sampling at fractional scales does not pick up a neighbour. Once a page
+// has all of its regions it becomes one texture shared by every sprite on it,
+// so the sprite batch draws them in one run.
+
+#define EMP_ATLAS_PADDING 1
+
+typedef struct emp_atlas_region_t
+{
+	u32 page;
+	// Top-left of the image on its page, inside the padding.
+	u32 x;
+	u32 y;
+	u32 width;
+	u32 height;
+	// Frames are `frame_size` squares laid out in a grid. 0 for an image
+	// without frames, which is one frame of its full size.
+	u32 frame_size;
+	u32 columns;
+	u32 rows;
+} emp_atlas_region_t;
+
+typedef struct emp_atlas_page_desc_t
+{
+	u32 width;
+	u32 height;
+	u32 region_count;
+} emp_atlas_page_desc_t;
+
+typedef struct emp_atlas_page_t
+{
+	SDL_Surface* surface;
+	SDL_Texture* texture;
+	u32 regions_missing;
+
+	// Textures on this page, pointed at `texture` once it exists.
+	emp_texture_t** users;
+	u32 user_count;
+	u32 user_capacity;
+} emp_atlas_page_t;
+
+typedef struct emp_atlas_t
+{
+	SDL_Renderer* renderer;
+	emp_atlas_page_t* pages;
+	u32 page_count;
+} emp_atlas_t;
+
+// Without a renderer (headless) no pages are allocated and placing a region
+// only records its size.
+void emp_atlas_init(emp_atlas_t* atlas, SDL_Renderer* renderer, const emp_atlas_page_desc_t* pages, u32 page_count);
+void emp_atlas_destroy(emp_atlas_t* atlas);
+
+// Fills in the size, frame grid and page origin of `texture`.
+void emp_texture_from_region(emp_texture_t* texture, const emp_atlas_region_t* region);
+
+// Main thread only. Copies `pixels` (RGBA32, region-sized) onto the region's
+// page, or into the page texture if it already exists, as on hot reload.
+// NULL pixels leave the region empty but still count it as placed.
+void emp_atlas_place(emp_atlas_t* atlas, emp_texture_t* texture, const emp_atlas_region_t* region, const void* pixels);
+// Forgets `texture` before it is freed.
+void emp_atlas_release(emp_atlas_t* atlas, emp_texture_t* texture, const emp_atlas_region_t* region);
@@ -0,0 +1,44 @@
+#pragma once
+#include "types.h"
+#include "miniaudio.h"
+
+struct SDL_IOStream;
+
+// Music played while it is decoded. The compressed file is read through an
+// SDL_IOStream in small chunks and a shared decoder thread keeps each open
+// stream's PCM ring topped up, so only open streams hold decoder state and
+// resident PCM is bounded by the ring. The stream loops back to the start of
+// the file at its end. When the decoder falls behind, `sound` plays silence
+// rather than stopping or blocking the mixer.
+
+#define EMP_AUDIO_STREAM_RING_FRAMES 16384
+
+typedef struct emp_audio_stream_t
+{
+	// Must come first: the stream is the data source `sound` plays from.
+	ma_data_source_base base;
+	ma_sound sound;
+	ma_decoder decoder;
+	ma_pcm_rb ring;
+	struct SDL_IOStream* io;
+	ma_uint32 channels;
+	ma_uint32 sample_rate;
+	bool at_start;
+	bool failed;
+	// Set under the decoder thread's lock once the stream is unlinked.
+	bool closing;
+	struct emp_audio_stream_t* next;
+} emp_audio_stream_t;
+
+// Streams `data` when it is non-NULL (an asset already resident, as when
+// packaged) and `path` otherwise. Returns NULL on failure; the sound is
+// initialised but not started.
+emp_audio_stream_t* emp_audio_stream_open(ma_engine* engine, const char* path, const void* data, size_t size);
+void emp_audio_stream_close(emp_audio_stream_t* stream);
+
+// Tops up every open stream on the calling thread. Only does work when the
+// decoder thread could not be started.
+void emp_audio_stream_update(void);
+
+// Stops the decoder thread. Every stream must be closed first.
+void emp_audio_stream_shutdown(void);
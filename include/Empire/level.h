@@ -2,21 +2,17 @@
 #include "Empire/types.h"
 struct emp_asset_t;
 
-#define emp_sublevel_capacity 16
-#define emp_value_buffer_capacity 512 * 512
-#define emp_entities_capacity 2048
-#define emp_teleporter_capacity 32
-
-typedef struct emp_value_buffer_t
+// Pixel position of a tile in its tileset and in its sublevel.
+typedef struct emp_tile_pos_t
 {
-	u8 values[emp_value_buffer_capacity];
-	u32 count;
-} emp_value_buffer_t;
+	u16 x;
+	u16 y;
+} emp_tile_pos_t;
 
 typedef struct emp_tile_desc_t
 {
-	emp_vec2_t src;
-	emp_vec2_t dst;
+	emp_tile_pos_t src;
+	emp_tile_pos_t dst;
 } emp_tile_desc_t;
 
 typedef struct emp_value_grid_t
@@ -24,14 +20,14 @@ typedef struct emp_value_grid_t
 	float grid_size;
 	u32 grid_width;
 	u32 grid_height;
-	u8* entries;
+	const u8* entries;
 	u32 count;
 } emp_value_grid_t;
 
 typedef struct emp_tiles_data_t
 {
-	char* tilemap;
-	emp_tile_desc_t* values;
+	const char* tilemap;
+	const emp_tile_desc_t* values;
 	u32 count;
 } emp_tiles_data_t;
 
@@ -53,16 +49,10 @@ typedef struct emp_sublevel_t
 
 typedef struct emp_sublevel_list_t
 {
-	emp_sublevel_t entries[emp_sublevel_capacity];
+	emp_sublevel_t* entries;
 	u32 count;
 } emp_sublevel_list_t;
 
-typedef struct emp_tile_desc_list_t
-{
-	emp_tile_desc_t entries[emp_value_buffer_capacity];
-	u32 count;
-} emp_tile_desc_list_t;
-
 typedef enum emp_entity_type {
 	emp_entity_type_player,
 	emp_entity_type_spawner,
@@ -97,7 +87,7 @@ typedef struct emp_level_entities_list_t
 {
 	float grid_size;
 
-	emp_level_entity_t entries[emp_entities_capacity];
+	const emp_level_entity_t* entries;
 	u32 count;
 } emp_level_entities_list_t;
 
@@ -113,25 +103,95 @@ typedef struct emp_level_teleporter_t
 	u64 other;
 } emp_level_teleporter_t;
 
+// Open-addressed by id; an id of 0 marks an empty slot.
 typedef struct emp_level_teleporter_list_t
 {
-	emp_level_teleporter_t entries[emp_teleporter_capacity];
+	const emp_level_teleporter_t* entries;
+	u32 capacity;
 	u32 count;
 }emp_level_teleporter_list_t;
 
 typedef struct emp_level_asset_t
 {
-	emp_tile_desc_list_t tiles;
-	emp_value_buffer_t values;
 	emp_sublevel_list_t sublevels;
 	emp_level_entities_list_t entities;
 	emp_level_teleporter_list_t teleporters;
+
+	// The level's one allocation. A compiled level only allocates its
+	// sublevels and points everything else into the asset's data; one parsed
+	// from JSON is compiled into here, sized by a counting pass.
+	void* memory;
 } emp_level_asset_t;
 
+// Packaged builds ship levels compiled by Florence from the LDtk JSON:
+//
+//   emp_level_file_header_t
+//   emp_level_file_sublevel_t[sublevel_count]
+//   emp_level_teleporter_t[teleporter_capacity]
+//   emp_tile_desc_t[tile_count]
+//   u8 values[value_count]
+//   char strings[string_size]
+//   emp_level_entity_t[entity_count]
+//
+// The arrays are the runtime structs, so loading checks every range and
+// points the level into the data rather than copying it. Each section starts
+// 8-byte aligned. Files without the magic are parsed as LDtk JSON.
+
+#define EMP_LEVEL_MAGIC 0x4c564c45u // "ELVL"
+#define EMP_LEVEL_VERSION 2
+// A string offset for a layer without a tileset.
+#define EMP_LEVEL_NO_STRING 0xffffffffu
+
+typedef struct emp_level_file_header_t
+{
+	u32 magic;
+	u32 version;
+	u32 sublevel_count;
+	u32 teleporter_capacity;
+	u32 teleporter_count;
+	u32 entity_count;
+	u32 tile_count;
+	u32 value_count;
+	u32 string_size;
+	float entity_grid_size;
+} emp_level_file_header_t;
+
+typedef struct emp_level_file_sublevel_t
+{
+	float offset_x;
+	float offset_y;
+
+	float grid_size;
+	u32 grid_width;
+	u32 grid_height;
+	u32 value_first;
+	u32 value_count;
+
+	// Ranges into the tile array and offsets into the strings.
+	u32 tile_first;
+	u32 tile_count;
+	u32 tilemap;
+
+	float decoration_grid_size;
+	u32 decoration_first;
+	u32 decoration_count;
+	u32 decoration_tilemap;
+} emp_level_file_sublevel_t;
+
+static inline emp_vec2_t emp_tile_world_pos(const emp_sublevel_t* sublevel, const emp_tile_desc_t* desc)
+{
+	return (emp_vec2_t) { sublevel->offset.x + (float)desc->dst.x, sublevel->offset.y + (float)desc->dst.y };
+}
+
 u32 emp_level_query(emp_level_asset_t* level, emp_entity_type type, u32 offset);
-emp_level_entity_t* emp_level_get(emp_level_asset_t* level, u32 at);
+const emp_level_entity_t* emp_level_get(emp_level_asset_t* level, u32 at);
+
+u32 emp_level_teleporter_list_find(const emp_level_teleporter_list_t* set, u64 id);
 
-u32 emp_level_teleporter_list_find(emp_level_teleporter_list_t* set, u64 id);
+// Compiles LDtk JSON into the binary format above. Returns an empty buffer
+// if the JSON does not parse, a tile does not fit emp_tile_pos_t or its
+// sublevel's grid, or the result would fail the loader's checks.
+emp_buffer emp_level_compile(const void* json, size_t size);
 
 void emp_load_level_asset(struct emp_asset_t* asset);
 void emp_unload_level_asset(struct emp_asset_t* asset);
@@ -0,0 +1,56 @@
+#pragma once
+#include "types.h"
+
+struct emp_asset_t;
+
+// Packaged builds ship every asset in one file written by Florence:
+//
+//   emp_package_header_t
+//   emp_package_entry_t[count]
+//   one block per asset, at the entry's offset
+//
+// Each block is either an independent LZ4 block or, when compressing does
+// not pay (OGG is already compressed), the raw bytes. The file is mapped
+// rather than read, stored assets point straight into the mapping, and LZ4
+// blocks are only decompressed when their asset is first loaded.
+
+#define EMP_PACKAGE_MAGIC 0x4b504d45u // "EMPK"
+#define EMP_PACKAGE_VERSION 1
+
+typedef struct emp_package_header_t
+{
+	u32 magic;
+	u32 version;
+	u32 count;
+	u32 reserved;
+} emp_package_header_t;
+
+typedef struct emp_package_entry_t
+{
+	u64 offset;
+	// 0 when the block is stored uncompressed.
+	u64 compressed_size;
+	u64 size;
+	u64 hash;
+} emp_package_entry_t;
+
+typedef struct emp_package_t
+{
+	const u8* base;
+	u64 size;
+	const emp_package_entry_t* entries;
+	u32 count;
+	// Platform mapping handles, or the loaded file where mapping is unavailable.
+	void* file;
+	void* mapping;
+} emp_package_t;
+
+bool emp_package_open(emp_package_t* package, const char* path);
+void emp_package_close(emp_package_t* package);
+
+// Points `asset` at entry `index`. Stored entries become resident at once
+// since they are only a view of the mapping.
+void emp_package_bind(emp_package_t* package, struct emp_asset_t* asset, u32 index);
+
+// Decompresses the asset's block into `asset->data` if it is not resident.
+void emp_package_load(struct emp_asset_t* asset);
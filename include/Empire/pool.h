@@ -0,0 +1,64 @@
+#pragma once
+#include "types.h"
+
+// Generational slot pool. Slot 0 is reserved so a zeroed handle is never valid.
+// A slot is alive while its generation is odd; alloc and free both bump it,
+// which makes stale handles fail emp_pool_is_valid without extra state.
+// Dead slots are chained through `next` into an intrusive free list, while
+// for live slots `next` is the slot's position in the packed `dense` array.
+// Iterate live slots with dense[0..count); walk it backwards when the loop
+// body may free the current slot, since free swaps the last entry into place.
+// Slots at or past `high_water` are free and chain sequentially through the
+// free list. Generations never move backwards for a free slot, so a handle
+// stays stale even across a snapshot restore.
+
+typedef struct emp_pool_slot_t
+{
+	u32 generation;
+	u32 next;
+} emp_pool_slot_t;
+
+typedef struct emp_pool_t
+{
+	emp_pool_slot_t* slots;
+	u32* dense;
+	u32 capacity;
+	u32 free_head;
+	u32 count;
+	u32 high_water;
+} emp_pool_t;
+
+void emp_pool_init(emp_pool_t* pool, u32 capacity);
+void emp_pool_destroy(emp_pool_t* pool);
+void emp_pool_clear(emp_pool_t* pool);
+
+// Returns the allocated slot index, or 0 when the pool is full.
+u32 emp_pool_alloc(emp_pool_t* pool);
+// Returns the dense position the slot vacated. The entry that used to be
+// last in `dense` (now at position `count`) has been moved there.
+u32 emp_pool_free(emp_pool_t* pool, u32 index);
+// Replaces the slot table with `high_water` saved slots. Live slots take the
+// saved generation so handles saved alongside them resolve again; free slots,
+// including those past the new high water mark, keep whichever generation is
+// newer so handles given out after the save stay stale.
+void emp_pool_restore_slots(emp_pool_t* pool, const void* slots, u32 high_water);
+
+static inline bool emp_pool_is_alive(const emp_pool_t* pool, u32 index)
+{
+	return index != 0 && index < pool->capacity && (pool->slots[index].generation & 1) != 0;
+}
+
+static inline bool emp_pool_is_valid(const emp_pool_t* pool, u32 index, u32 generation)
+{
+	return index != 0 && index < pool->capacity && pool->slots[index].generation == generation && (generation & 1) != 0;
+}
+
+static inline u32 emp_pool_generation(const emp_pool_t* pool, u32 index)
+{
+	return pool->slots[index].generation;
+}
+
+static inline u32 emp_pool_dense_index(const emp_pool_t* pool, u32 index)
+{
+	return pool->slots[index].next;
+}
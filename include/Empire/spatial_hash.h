@@ -0,0 +1,44 @@
+#pragma once
+#include "types.h"
+
+// Broadphase grid for entities that move every frame. Entries are queued
+// with emp_spatial_hash_insert and sorted into hashed buckets by
+// emp_spatial_hash_build with a counting sort, so a rebuild costs
+// O(entries) and the bucket table is sized from the entry count rather
+// than the level. An entry is added to every cell its radius overlaps,
+// which keeps entities larger than a cell visible to neighbourhood queries.
+
+typedef struct emp_spatial_entry_t
+{
+	i32 cx;
+	i32 cy;
+	u32 id;
+} emp_spatial_entry_t;
+
+typedef struct emp_spatial_hash_t
+{
+	float cell_size;
+	float inv_cell_size;
+
+	emp_spatial_entry_t* pending;
+	emp_spatial_entry_t* entries;
+	u32 count;
+	u32 capacity;
+
+	// buckets[b]..buckets[b + 1] is the range of `entries` hashed to b.
+	u32* buckets;
+	u32 bucket_mask;
+	u32 bucket_capacity;
+	bool built;
+} emp_spatial_hash_t;
+
+void emp_spatial_hash_init(emp_spatial_hash_t* hash, float cell_size);
+void emp_spatial_hash_destroy(emp_spatial_hash_t* hash);
+void emp_spatial_hash_clear(emp_spatial_hash_t* hash);
+
+void emp_spatial_hash_insert(emp_spatial_hash_t* hash, emp_vec2_t pos, float radius, u32 id);
+void emp_spatial_hash_build(emp_spatial_hash_t* hash);
+
+// Writes the ids found in the 3x3 cells around `pos` to `out`, each id once,
+// and returns how many were written (at most `max`).
+u32 emp_spatial_hash_query(const emp_spatial_hash_t* hash, emp_vec2_t pos, u32* out, u32 max);
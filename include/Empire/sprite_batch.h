@@ -0,0 +1,67 @@
+#pragma once
+#include "types.h"
+#include <SDL3/SDL_render.h>
+
+// Queues textured quads for the frame and submits them on flush with one
+// SDL_RenderGeometry call per run of consecutive sprites sharing a layer and
+// texture. Layers are drawn in ascending order; inside a layer sprites keep
+// their submission order, so later sprites always draw over earlier ones.
+// Colour is per vertex, so tints never touch texture state.
+// A negative dst width or height mirrors the quad, like SDL_RenderTexture.
+
+typedef struct emp_sprite_t
+{
+	float x0, y0, x1, y1;
+	float u0, v0, u1, v1;
+	SDL_FColor color;
+	u32 layer;
+	u32 texture;
+} emp_sprite_t;
+
+typedef struct emp_sprite_texture_t
+{
+	SDL_Texture* texture;
+	float inv_width;
+	float inv_height;
+} emp_sprite_texture_t;
+
+typedef struct emp_sprite_batch_t
+{
+	emp_sprite_t* sprites;
+	u32* order;
+	u32 count;
+	u32 capacity;
+
+	// Textures seen since the last flush; sprites refer to them by slot.
+	emp_sprite_texture_t* textures;
+	u32 texture_count;
+	u32 texture_capacity;
+	u32 last_texture;
+
+	u32* buckets;
+	u32 bucket_capacity;
+	u32 layer_count;
+
+	SDL_Vertex* vertices;
+	int* indices;
+
+	u32 draw_calls;
+} emp_sprite_batch_t;
+
+void emp_sprite_batch_init(emp_sprite_batch_t* batch, u32 layer_count);
+void emp_sprite_batch_destroy(emp_sprite_batch_t* batch);
+
+// `src` is in texels; NULL draws the whole texture.
+void emp_sprite_batch_draw(emp_sprite_batch_t* batch, u32 layer, SDL_Texture* texture, const SDL_FRect* src, const SDL_FRect* dst, SDL_FColor color);
+// Appends `count` sprites sharing a layer, texture and colour for the caller
+// to fill in: positions in pixels, UVs normalized. Returns NULL for a NULL
+// texture. The pointer is valid until the next draw, reserve or flush.
+emp_sprite_t* emp_sprite_batch_reserve(emp_sprite_batch_t* batch, u32 layer, SDL_Texture* texture, u32 count, SDL_FColor color);
+void emp_sprite_batch_flush(emp_sprite_batch_t* batch, SDL_Renderer* renderer);
+
+static inline SDL_FColor emp_sprite_color(u8 r, u8 g, u8 b, u8 a)
+{
+	return (SDL_FColor) { r / 255.0f, g / 255.0f, b / 255.0f, a / 255.0f };
+}
+
+#define EMP_SPRITE_WHITE ((SDL_FColor) { 1.0f, 1.0f, 1.0f, 1.0f })
@@ -6,12 +6,42 @@
 typedef struct SDL_Texture SDL_Texture;
 typedef struct SDL_Renderer SDL_Renderer;
 
+// Drawn strings are laid out once and cached on their font; after that a
+// string costs one hash lookup and a copy of its quads into the sprite batch.
+// Numbers skip the cache and formatting and are assembled from the digits.
+#define EMP_TEXT_CACHE_CAPACITY 256
+
+// A glyph quad relative to the pen: pixels, then normalized UVs.
+typedef struct emp_text_quad_t {
+    float x0, y0, x1, y1;
+    float u0, v0, u1, v1;
+} emp_text_quad_t;
+
+typedef struct emp_text_layout_t {
+    // The laid out string, compared on lookup since the key is only its hash.
+    char* text;
+    emp_text_quad_t* quads;
+    u32 count;
+} emp_text_layout_t;
+
+typedef struct emp_text_layout_kvp {
+    u64 key; // hash of the string
+    emp_text_layout_t value;
+} emp_text_layout_kvp;
+
 typedef struct emp_font_t {
     SDL_Texture* texture;
     stbtt_bakedchar cdata[96];
     float size;
+
+    emp_text_layout_kvp* layouts;
+    // '0' to '9' at a pen of 0, and how far each one moves it.
+    emp_text_quad_t digits[10];
+    float digit_advance[10];
 } emp_font_t;
 
 void emp_load_font(SDL_Renderer* renderer, emp_asset_t* font_asset, float size);
 
-void emp_draw_text(float x, float y, const char* text, u8 r, u8 g, u8 b, emp_asset_t* font_asset);
\ No newline at end of file
+// `layer` is the sprite batch layer to draw in.
+void emp_draw_text(float x, float y, const char* text, u8 r, u8 g, u8 b, emp_asset_t* font_asset, u32 layer);
+void emp_draw_number(float x, float y, u32 number, u8 r, u8 g, u8 b, emp_asset_t* font_asset, u32 layer);
@@ -8,6 +8,7 @@ typedef int64_t i64;
 typedef uint64_t u64;
 typedef uint32_t u32;
 typedef int32_t i32;
+typedef uint16_t u16;
 typedef uint8_t u8;
 
 typedef struct emp_buffer
@@ -25,6 +26,7 @@ typedef struct emp_compressed_buffer
 
 typedef struct SDL_Texture SDL_Texture;
 typedef struct SDL_Renderer SDL_Renderer;
+typedef struct SDL_Surface SDL_Surface;
 typedef struct emp_generated_assets_o emp_generated_assets_o;
 
 typedef struct emp_update_args_t
@@ -35,12 +37,18 @@ typedef struct emp_update_args_t
 
 typedef struct
 {
+	// Top-left of the image on its atlas page.
+	float x;
+	float y;
 	float width;
 	float height;
 	u32 source_size;
 	u32 rows;
 	u32 columns;
 	SDL_Texture* texture;
+	// Pixels decoded on a loader thread, until the texture is created from
+	// them on the main thread.
+	SDL_Surface* surface;
 } emp_texture_t;
 
 
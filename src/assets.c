@@ -1,11 +1,18 @@
 #include <Empire/assets.h>
 #include <Empire/generated/assets_generated.h>
 #include <Empire/hash.inl>
+#include <Empire/package.h>
 #include <Empire/stb_ds.h>
 #include <Empire/util.h>
 #include <SDL3/SDL.h>
 #include <stdio.h>
 
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
 typedef struct emp_generated_generic_t
 {
 	int count;
@@ -37,59 +44,448 @@ void emp_asset_manager_add_loader(emp_asset_manager_o* mgr, emp_asset_loader_t l
 	}
 }
 
-void emp_asset_manager_check_hot_reload(emp_asset_manager_o* mgr, float dt)
+// Loader threads claim jobs by bumping `next`; the main thread runs
+// `finish` for whichever jobs they have decoded.
+typedef struct emp_asset_job_t
+{
+	emp_asset_t* asset;
+	emp_asset_loader_t loader;
+} emp_asset_job_t;
+
+typedef struct emp_asset_loading_t
+{
+	emp_asset_job_t* jobs;
+	u32 job_count;
+	SDL_AtomicInt next;
+	// Main thread only: jobs not yet finished.
+	u32 remaining;
+
+	SDL_Thread** threads;
+	u32 thread_count;
+	SDL_Mutex* lock;
+	SDL_Condition* decoded;
+} emp_asset_loading_t;
+
+static bool run_load_job(emp_asset_loading_t* loading)
+{
+	int index = SDL_AddAtomicInt(&loading->next, 1);
+	if (index >= (int)loading->job_count) {
+		return false;
+	}
+	emp_asset_job_t* job = &loading->jobs[index];
+	emp_package_load(job->asset);
+	job->loader.load(job->asset);
+
+	SDL_LockMutex(loading->lock);
+	SDL_SetAtomicInt(&job->asset->state, EMP_ASSET_DECODED);
+	SDL_BroadcastCondition(loading->decoded);
+	SDL_UnlockMutex(loading->lock);
+	return true;
+}
+
+static int SDLCALL loader_thread(void* data)
+{
+	emp_asset_loading_t* loading = data;
+	while (run_load_job(loading)) {
+	}
+	return 0;
+}
+
+static void loading_destroy(emp_asset_loading_t* loading)
+{
+	for (u32 i = 0; i < loading->thread_count; ++i) {
+		SDL_WaitThread(loading->threads[i], NULL);
+	}
+	SDL_DestroyCondition(loading->decoded);
+	SDL_DestroyMutex(loading->lock);
+	SDL_free(loading->threads);
+	SDL_free(loading->jobs);
+	SDL_free(loading);
+}
+
+void emp_asset_manager_load_async(emp_asset_manager_o* mgr)
 {
-#ifdef FLORENCE_PACKAGE_ASSETS
-	(void)dt;
+	if (mgr->loading) {
+		return;
+	}
+	emp_asset_loading_t* loading = SDL_calloc(1, sizeof(emp_asset_loading_t));
+
 	u64 len = hmlen(mgr->assets_by_ext);
 	for (u64 i = 0; i < len; ++i) {
-		emp_asset_kvp* pair = &mgr->assets_by_ext[i];
-		emp_asset_loader_t loader = pair->value.loader;
-		if (loader.load && loader.unload) {
-			for (u64 j = 0; j < pair->value.count; ++j) {
-				emp_asset_t* asset = &pair->value.assets[j];
-				if (asset->handle == NULL) {
-					loader.load(asset);
+		emp_asset_type_t* type = &mgr->assets_by_ext[i].value;
+		if (type->loader.load && type->loader.unload) {
+			loading->jobs = SDL_realloc(loading->jobs, sizeof(emp_asset_job_t) * (loading->job_count + type->count));
+			for (u64 j = 0; j < type->count; ++j) {
+				emp_asset_t* asset = &type->assets[j];
+				if (SDL_GetAtomicInt(&asset->state) == EMP_ASSET_UNLOADED) {
+					SDL_SetAtomicInt(&asset->state, EMP_ASSET_LOADING);
+					loading->jobs[loading->job_count++] = (emp_asset_job_t) { .asset = asset, .loader = type->loader };
 				}
 			}
 		}
 	}
-#else
-	mgr->accumulator = mgr->accumulator + dt;
-	if (mgr->accumulator < 1.0f) {
+	if (loading->job_count == 0) {
+		SDL_free(loading->jobs);
+		SDL_free(loading);
 		return;
 	}
-	mgr->accumulator = 0;
+	loading->remaining = loading->job_count;
+	loading->lock = SDL_CreateMutex();
+	loading->decoded = SDL_CreateCondition();
+
+	// Without threads the jobs run on the main thread from wait and finish_loads.
+	u32 thread_count = SDL_min((u32)SDL_GetNumLogicalCPUCores(), loading->job_count);
+	loading->threads = SDL_malloc(sizeof(SDL_Thread*) * thread_count);
+	for (u32 i = 0; i < thread_count; ++i) {
+		SDL_Thread* thread = SDL_CreateThread(loader_thread, "emp_asset_loader", loading);
+		if (!thread) {
+			break;
+		}
+		loading->threads[loading->thread_count++] = thread;
+	}
+	mgr->loading = loading;
+}
+
+void emp_asset_manager_finish_loads(emp_asset_manager_o* mgr)
+{
+	emp_asset_loading_t* loading = mgr->loading;
+	if (!loading) {
+		return;
+	}
+	if (loading->thread_count == 0) {
+		run_load_job(loading);
+	}
+	for (u32 i = 0; i < loading->job_count; ++i) {
+		emp_asset_job_t* job = &loading->jobs[i];
+		if (SDL_GetAtomicInt(&job->asset->state) == EMP_ASSET_DECODED) {
+			if (job->loader.finish) {
+				job->loader.finish(job->asset);
+			}
+			SDL_SetAtomicInt(&job->asset->state, EMP_ASSET_LOADED);
+			loading->remaining--;
+		}
+	}
+	if (loading->remaining == 0) {
+		loading_destroy(loading);
+		mgr->loading = NULL;
+	}
+}
 
+void emp_asset_manager_wait(emp_asset_manager_o* mgr, emp_asset_t* asset)
+{
+	emp_asset_loading_t* loading = mgr->loading;
+	if (!loading || SDL_GetAtomicInt(&asset->state) == EMP_ASSET_LOADED) {
+		return;
+	}
+	// Decoding other queued assets is more useful than sleeping.
+	while (SDL_GetAtomicInt(&asset->state) == EMP_ASSET_LOADING && run_load_job(loading)) {
+	}
+	SDL_LockMutex(loading->lock);
+	while (SDL_GetAtomicInt(&asset->state) == EMP_ASSET_LOADING) {
+		SDL_WaitCondition(loading->decoded, loading->lock);
+	}
+	SDL_UnlockMutex(loading->lock);
+	emp_asset_manager_finish_loads(mgr);
+}
+
+void emp_asset_manager_wait_type(emp_asset_manager_o* mgr, u64 type)
+{
+	emp_asset_kvp* pair = stbds_hmgetp_null(mgr->assets_by_ext, type);
+	if (!pair) {
+		return;
+	}
+	for (u64 i = 0; i < pair->value.count; ++i) {
+		emp_asset_manager_wait(mgr, &pair->value.assets[i]);
+	}
+}
+
+void emp_asset_manager_load_all(emp_asset_manager_o* mgr)
+{
+	emp_asset_manager_load_async(mgr);
 	u64 len = hmlen(mgr->assets_by_ext);
 	for (u64 i = 0; i < len; ++i) {
-		emp_asset_kvp* pair = &mgr->assets_by_ext[i];
-		emp_asset_loader_t loader = pair->value.loader;
-		if (loader.load && loader.unload) {
-			for (u64 j = 0; j < pair->value.count; ++j) {
-				emp_asset_t* asset = &pair->value.assets[j];
-				SDL_PathInfo info;
-				SDL_GetPathInfo(asset->path, &info);
+		emp_asset_manager_wait_type(mgr, mgr->assets_by_ext[i].key);
+	}
+}
+
+#ifndef FLORENCE_PACKAGE_ASSETS
+
+// Power of two. A watcher with a full queue waits for the main thread.
+#define WATCH_QUEUE_CAPACITY 64
+#define WATCH_POLL_MS 100
+#define WATCH_STAT_INTERVAL_MS 1000
+
+typedef struct emp_watch_entry_t
+{
+	emp_asset_t* asset;
+	emp_asset_loader_t loader;
+	// The watcher's own copies; the main thread owns the asset's.
+	i64 last_modified;
+	u64 hash;
+	const char* name;
+	u32 dir;
+} emp_watch_entry_t;
+
+typedef struct emp_asset_reload_t
+{
+	emp_watch_entry_t* entry;
+	emp_buffer data;
+	u64 hash;
+} emp_asset_reload_t;
+
+typedef struct emp_asset_watcher_t
+{
+	emp_watch_entry_t* entries;
+	u32 entry_count;
+	char** dirs;
+	u32 dir_count;
+
+	// Single producer (the watcher), single consumer (the main thread).
+	emp_asset_reload_t queue[WATCH_QUEUE_CAPACITY];
+	SDL_AtomicInt head;
+	SDL_AtomicInt tail;
+
+	SDL_AtomicInt quit;
+	SDL_Thread* thread;
+} emp_asset_watcher_t;
+
+static void watch_push(emp_asset_watcher_t* watcher, emp_asset_reload_t reload)
+{
+	int tail = SDL_GetAtomicInt(&watcher->tail);
+	while (tail - SDL_GetAtomicInt(&watcher->head) == WATCH_QUEUE_CAPACITY) {
+		if (SDL_GetAtomicInt(&watcher->quit)) {
+			SDL_free(reload.data.data);
+			return;
+		}
+		SDL_Delay(10);
+	}
+	watcher->queue[tail & (WATCH_QUEUE_CAPACITY - 1)] = reload;
+	SDL_SetAtomicInt(&watcher->tail, tail + 1);
+}
+
+static void watch_read(emp_asset_watcher_t* watcher, emp_watch_entry_t* entry)
+{
+	emp_buffer data = emp_read_entire_file(entry->asset->path);
+	u64 hash = emp_hash_data(data);
+	if (hash == 0 || hash == entry->hash) {
+		SDL_free(data.data);
+		return;
+	}
+	entry->hash = hash;
+	watch_push(watcher, (emp_asset_reload_t) { .entry = entry, .data = data, .hash = hash });
+}
 
-				if (asset->handle == NULL) {
-					loader.load(asset);
-					asset->last_modified = info.modify_time;
+static void watch_stat(emp_asset_watcher_t* watcher, emp_watch_entry_t* entry)
+{
+	SDL_PathInfo info;
+	if (!SDL_GetPathInfo(entry->asset->path, &info) || info.modify_time == entry->last_modified) {
+		return;
+	}
+	entry->last_modified = info.modify_time;
+	watch_read(watcher, entry);
+}
+
+static void watch_poll(emp_asset_watcher_t* watcher)
+{
+	u64 next_stat = 0;
+	while (!SDL_GetAtomicInt(&watcher->quit)) {
+		if (SDL_GetTicks() >= next_stat) {
+			for (u32 i = 0; i < watcher->entry_count; ++i) {
+				watch_stat(watcher, &watcher->entries[i]);
+			}
+			next_stat = SDL_GetTicks() + WATCH_STAT_INTERVAL_MS;
+		}
+		SDL_Delay(WATCH_POLL_MS);
+	}
+}
+
+#ifdef __linux__
+// Returns false when inotify is unavailable, so the caller falls back to polling.
+static bool watch_inotify(emp_asset_watcher_t* watcher)
+{
+	int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+	int* wds = SDL_malloc(sizeof(int) * watcher->dir_count);
+	for (u32 i = 0; i < watcher->dir_count; ++i) {
+		// Editors either write in place or rename a temporary over the file.
+		wds[i] = inotify_add_watch(fd, watcher->dirs[i], IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (wds[i] < 0) {
+			SDL_free(wds);
+			close(fd);
+			return false;
+		}
+	}
+
+	_Alignas(struct inotify_event) char events[4096];
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+	while (!SDL_GetAtomicInt(&watcher->quit)) {
+		if (poll(&pfd, 1, WATCH_POLL_MS) <= 0) {
+			continue;
+		}
+		ssize_t len;
+		while ((len = read(fd, events, sizeof(events))) > 0) {
+			for (char* at = events; at < events + len;) {
+				struct inotify_event* event = (struct inotify_event*)at;
+				at += sizeof(struct inotify_event) + event->len;
+				if (event->len == 0) {
+					continue;
 				}
-				if (asset->last_modified != info.modify_time) {
-					emp_buffer new_data = emp_read_entire_file(asset->path);
-					u64 new_hash = emp_hash_data(new_data);
-					if (new_hash != 0 && new_hash != asset->hash) {
-						loader.unload(asset);
-						SDL_free(asset->data.data);
-						asset->data = new_data;
-						asset->hash = new_hash;
-						loader.load(asset);
-					} else {
-						SDL_free(new_data.data);
+				for (u32 i = 0; i < watcher->entry_count; ++i) {
+					emp_watch_entry_t* entry = &watcher->entries[i];
+					if (wds[entry->dir] == event->wd && SDL_strcmp(entry->name, event->name) == 0) {
+						watch_read(watcher, entry);
 					}
 				}
 			}
 		}
 	}
+	SDL_free(wds);
+	close(fd);
+	return true;
+}
+#endif
+
+static int SDLCALL watch_thread(void* data)
+{
+	emp_asset_watcher_t* watcher = data;
+#ifdef __linux__
+	if (watch_inotify(watcher)) {
+		return 0;
+	}
+	SDL_Log("inotify unavailable, polling assets for hot reload");
+#endif
+	watch_poll(watcher);
+	return 0;
+}
+
+static u32 watch_add_dir(emp_asset_watcher_t* watcher, const char* path, const char** name)
+{
+	const char* slash = SDL_strrchr(path, '/');
+	*name = slash ? slash + 1 : path;
+	char* dir = slash ? SDL_strndup(path, (size_t)(slash - path)) : SDL_strdup(".");
+	for (u32 i = 0; i < watcher->dir_count; ++i) {
+		if (SDL_strcmp(watcher->dirs[i], dir) == 0) {
+			SDL_free(dir);
+			return i;
+		}
+	}
+	watcher->dirs = SDL_realloc(watcher->dirs, sizeof(char*) * (watcher->dir_count + 1));
+	watcher->dirs[watcher->dir_count] = dir;
+	return watcher->dir_count++;
+}
+
+void emp_asset_manager_watch(emp_asset_manager_o* mgr)
+{
+	if (mgr->watcher) {
+		return;
+	}
+	emp_asset_watcher_t* watcher = SDL_calloc(1, sizeof(emp_asset_watcher_t));
+
+	u64 len = hmlen(mgr->assets_by_ext);
+	for (u64 i = 0; i < len; ++i) {
+		emp_asset_type_t* type = &mgr->assets_by_ext[i].value;
+		if (type->loader.load && type->loader.unload) {
+			watcher->entries = SDL_realloc(watcher->entries, sizeof(emp_watch_entry_t) * (watcher->entry_count + type->count));
+			for (u64 j = 0; j < type->count; ++j) {
+				emp_asset_t* asset = &type->assets[j];
+				// Streamed assets are never resident; the next stream opened reads the new file.
+				if (asset->data.data == NULL) {
+					continue;
+				}
+				emp_watch_entry_t* entry = &watcher->entries[watcher->entry_count++];
+				entry->asset = asset;
+				entry->loader = type->loader;
+				entry->hash = asset->hash;
+				SDL_PathInfo info;
+				entry->last_modified = SDL_GetPathInfo(asset->path, &info) ? info.modify_time : 0;
+				entry->dir = watch_add_dir(watcher, asset->path, &entry->name);
+			}
+		}
+	}
+
+	watcher->thread = SDL_CreateThread(watch_thread, "emp_asset_watcher", watcher);
+	if (!watcher->thread) {
+		SDL_Log("Failed to start the asset watcher, hot reload is off: %s", SDL_GetError());
+	}
+	mgr->watcher = watcher;
+}
+
+void emp_asset_manager_check_hot_reload(emp_asset_manager_o* mgr)
+{
+	emp_asset_watcher_t* watcher = mgr->watcher;
+	if (!watcher) {
+		return;
+	}
+	int head = SDL_GetAtomicInt(&watcher->head);
+	int tail = SDL_GetAtomicInt(&watcher->tail);
+	for (; head != tail; ++head) {
+		emp_asset_reload_t* reload = &watcher->queue[head & (WATCH_QUEUE_CAPACITY - 1)];
+		emp_asset_t* asset = reload->entry->asset;
+		emp_asset_loader_t loader = reload->entry->loader;
+		if (!emp_asset_is_loaded(asset)) {
+			// Still being loaded at startup; swap it in on a later frame.
+			break;
+		}
+		if (reload->hash != asset->hash) {
+			loader.unload(asset);
+			SDL_free(asset->data.data);
+			asset->data = reload->data;
+			asset->hash = reload->hash;
+			loader.load(asset);
+			if (loader.finish) {
+				loader.finish(asset);
+			}
+		} else {
+			SDL_free(reload->data.data);
+		}
+		SDL_SetAtomicInt(&watcher->head, head + 1);
+	}
+}
+
+static void watch_destroy(emp_asset_watcher_t* watcher)
+{
+	SDL_SetAtomicInt(&watcher->quit, 1);
+	if (watcher->thread) {
+		SDL_WaitThread(watcher->thread, NULL);
+	}
+	for (int i = SDL_GetAtomicInt(&watcher->head); i != SDL_GetAtomicInt(&watcher->tail); ++i) {
+		SDL_free(watcher->queue[i & (WATCH_QUEUE_CAPACITY - 1)].data.data);
+	}
+	for (u32 i = 0; i < watcher->dir_count; ++i) {
+		SDL_free(watcher->dirs[i]);
+	}
+	SDL_free(watcher->dirs);
+	SDL_free(watcher->entries);
+	SDL_free(watcher);
+}
+
+#else
+
+void emp_asset_manager_watch(emp_asset_manager_o* mgr)
+{
+	(void)mgr;
+}
+
+void emp_asset_manager_check_hot_reload(emp_asset_manager_o* mgr)
+{
+	(void)mgr;
+}
+
 #endif
-}
\ No newline at end of file
+
+void emp_asset_manager_destroy(emp_asset_manager_o* mgr)
+{
+	if (mgr->loading) {
+		loading_destroy(mgr->loading);
+	}
+#ifndef FLORENCE_PACKAGE_ASSETS
+	if (mgr->watcher) {
+		watch_destroy(mgr->watcher);
+	}
+#endif
+	hmfree(mgr->assets_by_ext);
+	shfree(mgr->assets_by_path);
+	SDL_free(mgr);
+}
@@ -0,0 +1,130 @@
+#include <Empire/atlas.h>
+#include <SDL3/SDL.h>
+
+void emp_atlas_init(emp_atlas_t* atlas, SDL_Renderer* renderer, const emp_atlas_page_desc_t* pages, u32 page_count)
+{
+	SDL_zerop(atlas);
+	atlas->renderer = renderer;
+	if (!renderer) {
+		return;
+	}
+	atlas->page_count = page_count;
+	atlas->pages = SDL_calloc(page_count, sizeof(emp_atlas_page_t));
+	for (u32 i = 0; i < page_count; ++i) {
+		emp_atlas_page_t* page = &atlas->pages[i];
+		page->surface = SDL_CreateSurface((int)pages[i].width, (int)pages[i].height, SDL_PIXELFORMAT_RGBA32);
+		SDL_ClearSurface(page->surface, 0.0f, 0.0f, 0.0f, 0.0f);
+		page->regions_missing = pages[i].region_count;
+	}
+}
+
+void emp_atlas_destroy(emp_atlas_t* atlas)
+{
+	for (u32 i = 0; i < atlas->page_count; ++i) {
+		emp_atlas_page_t* page = &atlas->pages[i];
+		SDL_DestroySurface(page->surface);
+		SDL_DestroyTexture(page->texture);
+		SDL_free(page->users);
+	}
+	SDL_free(atlas->pages);
+	SDL_zerop(atlas);
+}
+
+void emp_texture_from_region(emp_texture_t* texture, const emp_atlas_region_t* region)
+{
+	texture->texture = NULL;
+	texture->surface = NULL;
+	texture->x = (float)region->x;
+	texture->y = (float)region->y;
+	texture->columns = region->columns;
+	texture->rows = region->rows;
+	if (region->frame_size) {
+		texture->source_size = region->frame_size;
+		texture->width = (float)region->frame_size;
+		texture->height = (float)region->frame_size;
+	} else {
+		texture->source_size = region->width;
+		texture->width = (float)region->width;
+		texture->height = (float)region->height;
+	}
+}
+
+// Writes the image with its edge texels repeated EMP_ATLAS_PADDING texels
+// out on every side; `dst` is the padded top-left.
+static void write_padded(u8* dst, int pitch, const u8* pixels, u32 width, u32 height)
+{
+	u32 row_bytes = width * 4;
+	u32 pad_bytes = EMP_ATLAS_PADDING * 4;
+	for (u32 y = 0; y < height + EMP_ATLAS_PADDING * 2; ++y) {
+		u32 sy = y < EMP_ATLAS_PADDING ? 0 : SDL_min(y - EMP_ATLAS_PADDING, height - 1);
+		const u8* src = pixels + (size_t)sy * row_bytes;
+		u8* out = dst + (size_t)y * (size_t)pitch;
+		for (u32 x = 0; x < EMP_ATLAS_PADDING; ++x) {
+			SDL_memcpy(out + x * 4, src, 4);
+			SDL_memcpy(out + pad_bytes + row_bytes + x * 4, src + row_bytes - 4, 4);
+		}
+		SDL_memcpy(out + pad_bytes, src, row_bytes);
+	}
+}
+
+void emp_atlas_place(emp_atlas_t* atlas, emp_texture_t* texture, const emp_atlas_region_t* region, const void* pixels)
+{
+	if (region->page >= atlas->page_count) {
+		return;
+	}
+	emp_atlas_page_t* page = &atlas->pages[region->page];
+	SDL_Rect padded = {
+		(int)region->x - EMP_ATLAS_PADDING,
+		(int)region->y - EMP_ATLAS_PADDING,
+		(int)region->width + EMP_ATLAS_PADDING * 2,
+		(int)region->height + EMP_ATLAS_PADDING * 2,
+	};
+
+	if (!pixels) {
+		// The image failed to load; its region stays transparent.
+		if (!page->texture) {
+			page->regions_missing--;
+		}
+	} else if (page->texture) {
+		int pitch = padded.w * 4;
+		u8* staging = SDL_malloc((size_t)pitch * (size_t)padded.h);
+		write_padded(staging, pitch, pixels, region->width, region->height);
+		SDL_UpdateTexture(page->texture, &padded, staging, pitch);
+		SDL_free(staging);
+	} else {
+		u8* dst = (u8*)page->surface->pixels + (size_t)padded.y * (size_t)page->surface->pitch + (size_t)padded.x * 4;
+		write_padded(dst, page->surface->pitch, pixels, region->width, region->height);
+		page->regions_missing--;
+	}
+
+	if (page->user_count == page->user_capacity) {
+		page->user_capacity = page->user_capacity ? page->user_capacity * 2 : 16;
+		page->users = SDL_realloc(page->users, sizeof(emp_texture_t*) * page->user_capacity);
+	}
+	page->users[page->user_count++] = texture;
+	texture->texture = page->texture;
+
+	if (!page->texture && page->regions_missing == 0) {
+		page->texture = SDL_CreateTextureFromSurface(atlas->renderer, page->surface);
+		SDL_SetTextureScaleMode(page->texture, SDL_SCALEMODE_NEAREST);
+		SDL_DestroySurface(page->surface);
+		page->surface = NULL;
+		for (u32 i = 0; i < page->user_count; ++i) {
+			page->users[i]->texture = page->texture;
+		}
+	}
+}
+
+void emp_atlas_release(emp_atlas_t* atlas, emp_texture_t* texture, const emp_atlas_region_t* region)
+{
+	if (region->page >= atlas->page_count) {
+		return;
+	}
+	emp_atlas_page_t* page = &atlas->pages[region->page];
+	for (u32 i = 0; i < page->user_count; ++i) {
+		if (page->users[i] == texture) {
+			page->users[i] = page->users[--page->user_count];
+			break;
+		}
+	}
+}
@@ -0,0 +1,283 @@
+#include <Empire/audio_stream.h>
+#include <SDL3/SDL.h>
+
+// Decoded per stream per pass, which bounds how long closing a stream waits
+// for the decoder thread to finish with it.
+#define STREAM_CHUNK_FRAMES 4096
+// The mixer never signals that it drained a ring, so the thread polls.
+#define STREAM_POLL_MS 10
+
+static SDL_Thread* g_stream_thread;
+static SDL_Mutex* g_stream_lock;
+static SDL_Condition* g_stream_wake;
+static SDL_Condition* g_stream_idle;
+static bool g_stream_quit;
+static bool g_stream_thread_failed;
+// Guarded by g_stream_lock. The thread decodes `g_stream_busy` with the
+// lock released, so only walking and changing the list wait on each other.
+static emp_audio_stream_t* g_streams;
+static emp_audio_stream_t* g_stream_busy;
+
+static ma_result stream_io_read(ma_decoder* decoder, void* out, size_t bytes, size_t* bytes_read)
+{
+	emp_audio_stream_t* stream = decoder->pUserData;
+	*bytes_read = SDL_ReadIO(stream->io, out, bytes);
+	return *bytes_read == 0 && bytes > 0 ? MA_AT_END : MA_SUCCESS;
+}
+
+static ma_result stream_io_seek(ma_decoder* decoder, ma_int64 offset, ma_seek_origin origin)
+{
+	emp_audio_stream_t* stream = decoder->pUserData;
+	SDL_IOWhence whence = SDL_IO_SEEK_CUR;
+	if (origin == ma_seek_origin_start) {
+		whence = SDL_IO_SEEK_SET;
+	} else if (origin == ma_seek_origin_end) {
+		whence = SDL_IO_SEEK_END;
+	}
+	return SDL_SeekIO(stream->io, offset, whence) < 0 ? MA_ERROR : MA_SUCCESS;
+}
+
+static ma_result stream_read(ma_data_source* source, void* out, ma_uint64 frame_count, ma_uint64* frames_read)
+{
+	emp_audio_stream_t* stream = source;
+	ma_uint32 frame_bytes = ma_get_bytes_per_frame(ma_format_f32, stream->channels);
+
+	ma_uint64 done = 0;
+	while (done < frame_count) {
+		ma_uint32 frames = (ma_uint32)SDL_min(frame_count - done, EMP_AUDIO_STREAM_RING_FRAMES);
+		void* src;
+		if (ma_pcm_rb_acquire_read(&stream->ring, &frames, &src) != MA_SUCCESS || frames == 0) {
+			break;
+		}
+		if (out) {
+			SDL_memcpy((u8*)out + done * frame_bytes, src, (size_t)frames * frame_bytes);
+		}
+		ma_pcm_rb_commit_read(&stream->ring, frames);
+		done += frames;
+	}
+	if (out && done < frame_count) {
+		SDL_memset((u8*)out + done * frame_bytes, 0, (size_t)(frame_count - done) * frame_bytes);
+	}
+	if (frames_read) {
+		*frames_read = frame_count;
+	}
+	return MA_SUCCESS;
+}
+
+static ma_result stream_seek(ma_data_source* source, ma_uint64 frame_index)
+{
+	(void)source;
+	(void)frame_index;
+	return MA_NOT_IMPLEMENTED;
+}
+
+static ma_result stream_get_data_format(ma_data_source* source, ma_format* format, ma_uint32* channels, ma_uint32* sample_rate, ma_channel* channel_map, size_t channel_map_cap)
+{
+	emp_audio_stream_t* stream = source;
+	*format = ma_format_f32;
+	*channels = stream->channels;
+	*sample_rate = stream->sample_rate;
+	ma_channel_map_init_standard(ma_standard_channel_map_default, channel_map, channel_map_cap, stream->channels);
+	return MA_SUCCESS;
+}
+
+static ma_data_source_vtable g_stream_vtable = {
+	.onRead = stream_read,
+	.onSeek = stream_seek,
+	.onGetDataFormat = stream_get_data_format,
+};
+
+// Decodes up to one chunk into the ring. Returns true while the ring still
+// has room, so the caller knows to come back before sleeping.
+static bool stream_fill(emp_audio_stream_t* stream)
+{
+	if (stream->failed) {
+		return false;
+	}
+	ma_uint32 frames = SDL_min(ma_pcm_rb_available_write(&stream->ring), STREAM_CHUNK_FRAMES);
+	if (frames == 0) {
+		return false;
+	}
+
+	void* dst;
+	ma_pcm_rb_acquire_write(&stream->ring, &frames, &dst);
+	ma_uint64 decoded = 0;
+	ma_decoder_read_pcm_frames(&stream->decoder, dst, frames, &decoded);
+	ma_pcm_rb_commit_write(&stream->ring, (ma_uint32)decoded);
+
+	if (decoded > 0) {
+		stream->at_start = false;
+	}
+	if (decoded < frames) {
+		// Every streamed track loops. A file that yields nothing even from
+		// the start would spin here forever, so it is given up on instead.
+		if (stream->at_start || ma_decoder_seek_to_pcm_frame(&stream->decoder, 0) != MA_SUCCESS) {
+			stream->failed = true;
+			return false;
+		}
+		stream->at_start = true;
+	}
+	return true;
+}
+
+static int SDLCALL stream_thread(void* data)
+{
+	(void)data;
+	SDL_LockMutex(g_stream_lock);
+	while (!g_stream_quit) {
+		bool more = false;
+		emp_audio_stream_t* stream = g_streams;
+		while (stream) {
+			g_stream_busy = stream;
+			SDL_UnlockMutex(g_stream_lock);
+			bool filled = stream_fill(stream);
+			SDL_LockMutex(g_stream_lock);
+			g_stream_busy = NULL;
+			SDL_BroadcastCondition(g_stream_idle);
+			more |= filled;
+			// A stream closed while it was decoding has been unlinked and its
+			// `next` may be stale, so the walk starts over.
+			stream = stream->closing ? g_streams : stream->next;
+		}
+		if (!more) {
+			SDL_WaitConditionTimeout(g_stream_wake, g_stream_lock, STREAM_POLL_MS);
+		}
+	}
+	SDL_UnlockMutex(g_stream_lock);
+	return 0;
+}
+
+static void stream_start_thread(void)
+{
+	if (g_stream_thread || g_stream_thread_failed) {
+		return;
+	}
+	g_stream_lock = SDL_CreateMutex();
+	g_stream_wake = SDL_CreateCondition();
+	g_stream_idle = SDL_CreateCondition();
+	g_stream_quit = false;
+	g_stream_thread = SDL_CreateThread(stream_thread, "emp_audio_stream", NULL);
+	if (!g_stream_thread) {
+		SDL_Log("Failed to start the music decoder thread, decoding on the main thread: %s", SDL_GetError());
+		g_stream_thread_failed = true;
+	}
+}
+
+emp_audio_stream_t* emp_audio_stream_open(ma_engine* engine, const char* path, const void* data, size_t size)
+{
+	emp_audio_stream_t* stream = SDL_calloc(1, sizeof(emp_audio_stream_t));
+	stream->channels = ma_engine_get_channels(engine);
+	stream->sample_rate = ma_engine_get_sample_rate(engine);
+	stream->at_start = true;
+	stream->io = data ? SDL_IOFromConstMem(data, size) : SDL_IOFromFile(path, "rb");
+	if (!stream->io) {
+		SDL_Log("Failed to open music stream '%s': %s", path, SDL_GetError());
+		SDL_free(stream);
+		return NULL;
+	}
+
+	ma_decoder_config decoder_config = ma_decoder_config_init(ma_format_f32, stream->channels, stream->sample_rate);
+	ma_result result = ma_decoder_init(stream_io_read, stream_io_seek, stream, &decoder_config, &stream->decoder);
+	if (result != MA_SUCCESS) {
+		SDL_Log("Failed to open music stream '%s': miniaudio error %d", path, result);
+		SDL_CloseIO(stream->io);
+		SDL_free(stream);
+		return NULL;
+	}
+
+	ma_data_source_config source_config = ma_data_source_config_init();
+	source_config.vtable = &g_stream_vtable;
+	ma_data_source_init(&source_config, &stream->base);
+	ma_pcm_rb_init(ma_format_f32, stream->channels, EMP_AUDIO_STREAM_RING_FRAMES, NULL, NULL, &stream->ring);
+
+	result = ma_sound_init_from_data_source(engine, stream, MA_SOUND_FLAG_NO_SPATIALIZATION, NULL, &stream->sound);
+	if (result != MA_SUCCESS) {
+		SDL_Log("Failed to open music stream '%s': miniaudio error %d", path, result);
+		ma_pcm_rb_uninit(&stream->ring);
+		ma_data_source_uninit(&stream->base);
+		ma_decoder_uninit(&stream->decoder);
+		SDL_CloseIO(stream->io);
+		SDL_free(stream);
+		return NULL;
+	}
+
+	// Prime one chunk so the track does not open on silence.
+	stream_fill(stream);
+
+	stream_start_thread();
+	if (g_stream_lock) {
+		SDL_LockMutex(g_stream_lock);
+	}
+	stream->next = g_streams;
+	g_streams = stream;
+	if (g_stream_lock) {
+		SDL_SignalCondition(g_stream_wake);
+		SDL_UnlockMutex(g_stream_lock);
+	}
+	return stream;
+}
+
+void emp_audio_stream_close(emp_audio_stream_t* stream)
+{
+	if (!stream) {
+		return;
+	}
+	// Detaches from the node graph, after which the mixer no longer reads the ring.
+	ma_sound_uninit(&stream->sound);
+
+	if (g_stream_lock) {
+		SDL_LockMutex(g_stream_lock);
+	}
+	for (emp_audio_stream_t** it = &g_streams; *it; it = &(*it)->next) {
+		if (*it == stream) {
+			*it = stream->next;
+			break;
+		}
+	}
+	stream->closing = true;
+	if (g_stream_lock) {
+		while (g_stream_busy == stream) {
+			SDL_WaitCondition(g_stream_idle, g_stream_lock);
+		}
+		SDL_UnlockMutex(g_stream_lock);
+	}
+
+	ma_pcm_rb_uninit(&stream->ring);
+	ma_data_source_uninit(&stream->base);
+	ma_decoder_uninit(&stream->decoder);
+	SDL_CloseIO(stream->io);
+	SDL_free(stream);
+}
+
+void emp_audio_stream_update(void)
+{
+	if (g_stream_thread) {
+		return;
+	}
+	for (emp_audio_stream_t* stream = g_streams; stream; stream = stream->next) {
+		while (stream_fill(stream)) {
+		}
+	}
+}
+
+void emp_audio_stream_shutdown(void)
+{
+	SDL_assert(g_streams == NULL && "Close every audio stream before shutting down");
+	if (g_stream_thread) {
+		SDL_LockMutex(g_stream_lock);
+		g_stream_quit = true;
+		SDL_SignalCondition(g_stream_wake);
+		SDL_UnlockMutex(g_stream_lock);
+		SDL_WaitThread(g_stream_thread, NULL);
+		g_stream_thread = NULL;
+	}
+	if (g_stream_lock) {
+		SDL_DestroyCondition(g_stream_wake);
+		SDL_DestroyCondition(g_stream_idle);
+		SDL_DestroyMutex(g_stream_lock);
+		g_stream_wake = NULL;
+		g_stream_idle = NULL;
+		g_stream_lock = NULL;
+	}
+	g_stream_thread_failed = false;
+}
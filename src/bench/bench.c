@@ -0,0 +1,545 @@
+// EmpireBench: times the simulation hot paths in isolation.
+//
+// Every scenario is built from a seeded generator, so two runs with the same
+// seed time the same work. Results are reported as min/median/p99 ns per
+// operation and written as JSON (to stdout, or to `out=path`) so runs from
+// different commits can be diffed.
+//
+// Arguments: cwd=<asset root> seed=<n> samples=<n> out=<path>
+
+#include <Empire/types.h>
+#include <SDL3/SDL.h>
+
+#include "../entities.h"
+#include "../snapshot.h"
+
+#include <Empire/assets.h>
+#include <Empire/atlas.h>
+#include <Empire/generated/assets_generated.h>
+#include <Empire/level.h>
+
+#include <stdio.h>
+
+#define BENCH_MAX_RESULTS 32
+#define BENCH_WARMUP_SAMPLES 5
+#define BENCH_DT (1.0f / 120.0f)
+
+typedef void (*bench_f)(void* ctx, u32 ops);
+
+typedef struct bench_result_t
+{
+	char name[48];
+	u32 ops_per_sample;
+	u32 samples;
+	double min_ns;
+	double median_ns;
+	double p99_ns;
+} bench_result_t;
+
+typedef struct bench_t
+{
+	u64 seed;
+	u32 samples;
+	double* sample_ns;
+	bench_result_t results[BENCH_MAX_RESULTS];
+	u32 result_count;
+} bench_t;
+
+static u32 bench_rng_state;
+
+static u32 bench_rng(void)
+{
+	// xorshift32; never seeded with zero.
+	u32 x = bench_rng_state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	bench_rng_state = x;
+	return x;
+}
+
+static float bench_rng_range(float min, float max)
+{
+	return min + (float)(bench_rng() >> 8) * (1.0f / 16777216.0f) * (max - min);
+}
+
+static void bench_reseed(bench_t* bench)
+{
+	bench_rng_state = (u32)(bench->seed ^ (bench->seed >> 32)) | 1u;
+}
+
+static int compare_double(const void* a, const void* b)
+{
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+// `setup`, when given, runs untimed before every sample.
+static void bench_run_with_setup(bench_t* bench, const char* name, bench_f setup, bench_f fn, void* ctx, u32 ops_per_sample)
+{
+	SDL_assert(bench->result_count < BENCH_MAX_RESULTS);
+	double ticks_to_ns = 1e9 / (double)SDL_GetPerformanceFrequency();
+
+	for (u32 i = 0; i < BENCH_WARMUP_SAMPLES; ++i) {
+		if (setup) {
+			setup(ctx, ops_per_sample);
+		}
+		fn(ctx, ops_per_sample);
+	}
+
+	for (u32 i = 0; i < bench->samples; ++i) {
+		if (setup) {
+			setup(ctx, ops_per_sample);
+		}
+		u64 start = SDL_GetPerformanceCounter();
+		fn(ctx, ops_per_sample);
+		u64 end = SDL_GetPerformanceCounter();
+		bench->sample_ns[i] = (double)(end - start) * ticks_to_ns / ops_per_sample;
+	}
+
+	SDL_qsort(bench->sample_ns, bench->samples, sizeof(double), compare_double);
+
+	// Nearest-rank percentile.
+	u32 p99 = (u32)SDL_ceil(bench->samples * 0.99) - 1;
+
+	bench_result_t* result = &bench->results[bench->result_count++];
+	SDL_strlcpy(result->name, name, sizeof(result->name));
+	result->ops_per_sample = ops_per_sample;
+	result->samples = bench->samples;
+	result->min_ns = bench->sample_ns[0];
+	result->median_ns = bench->sample_ns[bench->samples / 2];
+	result->p99_ns = bench->sample_ns[p99];
+
+	SDL_Log("%-28s min %12.1f  median %12.1f  p99 %12.1f  ns/op", name, result->min_ns, result->median_ns, result->p99_ns);
+}
+
+static void bench_run(bench_t* bench, const char* name, bench_f fn, void* ctx, u32 ops_per_sample)
+{
+	bench_run_with_setup(bench, name, NULL, fn, ctx, ops_per_sample);
+}
+
+static void reset_entities(void)
+{
+	emp_pool_clear(&G->enemy_pool);
+	emp_pool_clear(&G->bullet_pool);
+	emp_spatial_hash_clear(&G->enemy_grid);
+}
+
+static void spawn_random_bullets(u32 count, emp_vec2_t min, emp_vec2_t max)
+{
+	emp_bullets_t* bullets = G->bullets;
+	for (u32 i = 0; i < count; ++i) {
+		emp_bullet_h handle = emp_create_bullet();
+		u32 at = emp_pool_dense_index(&G->bullet_pool, handle.index);
+		float angle = bench_rng_range(0.0f, 2.0f * SDL_PI_F);
+		float speed = bench_rng_range(100.0f, 400.0f);
+		bullets->x[at] = bench_rng_range(min.x, max.x);
+		bullets->y[at] = bench_rng_range(min.y, max.y);
+		bullets->vx[at] = SDL_cosf(angle) * speed;
+		bullets->vy[at] = SDL_sinf(angle) * speed;
+		bullets->life[at] = bench_rng_range(1.0f, 10.0f);
+		bullets->damage[at] = 1.0f;
+		bullets->mask[at] = emp_enemy_bullet_mask;
+		bullets->texture_asset[at] = &G->assets->png->bullet_8;
+	}
+}
+
+// Bullet integration ------------------------------------------------------
+
+static void bench_bullet_integrate(void* ctx, u32 ops)
+{
+	u32 count = *(u32*)ctx;
+	for (u32 i = 0; i < ops; ++i) {
+		emp_bullets_integrate(G->bullets, count, BENCH_DT);
+	}
+}
+
+// Bullet vs enemy collision -----------------------------------------------
+
+typedef struct bench_collision_t
+{
+	emp_vec2_t* points;
+	u32 point_count;
+	u32 next;
+	u32 hits;
+} bench_collision_t;
+
+// Mirrors the enemy half of emp_bullet_update: a grid query followed by the
+// exact overlap test on each candidate.
+static void bench_bullet_enemy(void* ctx, u32 ops)
+{
+	bench_collision_t* c = ctx;
+	for (u32 i = 0; i < ops; ++i) {
+		emp_vec2_t pos = c->points[c->next];
+		c->next = (c->next + 1) % c->point_count;
+
+		u32 nearby[64];
+		u32 nearby_count = emp_spatial_hash_query(&G->enemy_grid, pos, nearby, SDL_arraysize(nearby));
+		for (u32 n = 0; n < nearby_count; ++n) {
+			if (check_overlap_bullet_enemy(pos, &G->enemies[nearby[n]])) {
+				c->hits++;
+				break;
+			}
+		}
+	}
+}
+
+static void setup_enemy_field(u32 enemy_count, float extent)
+{
+	reset_entities();
+	for (u32 i = 0; i < enemy_count; ++i) {
+		emp_vec2_t pos = { bench_rng_range(0.0f, extent), bench_rng_range(0.0f, extent) };
+		emp_create_enemy(pos, bench_rng() % 4, 0.0f, 0.0f, 0, (emp_spawner_h) { 0 });
+	}
+	for (u32 i = G->enemy_pool.count; i-- > 0;) {
+		u32 index = G->enemy_pool.dense[i];
+		emp_enemy_t* enemy = &G->enemies[index];
+		emp_spatial_hash_insert(&G->enemy_grid, enemy->pos, enemy_collision_radius(enemy), index);
+	}
+	emp_spatial_hash_build(&G->enemy_grid);
+}
+
+// Bullet allocation churn -------------------------------------------------
+
+typedef struct bench_churn_t
+{
+	emp_bullet_h* handles;
+	u32* order;
+} bench_churn_t;
+
+// One op is a create plus a destroy; bullets die in shuffled order, the way
+// lifetimes and hits retire them in game.
+static void bench_bullet_churn(void* ctx, u32 ops)
+{
+	bench_churn_t* c = ctx;
+	for (u32 i = 0; i < ops; ++i) {
+		c->handles[i] = emp_create_bullet();
+	}
+	for (u32 i = 0; i < ops; ++i) {
+		emp_destroy_bullet(c->handles[c->order[i]]);
+	}
+}
+
+// Level collision ---------------------------------------------------------
+
+typedef struct bench_level_query_t
+{
+	emp_vec2_t* points;
+	u32 point_count;
+	u32 next;
+	u32 hits;
+} bench_level_query_t;
+
+static void bench_level_query(void* ctx, u32 ops)
+{
+	bench_level_query_t* q = ctx;
+	for (u32 i = 0; i < ops; ++i) {
+		q->hits += check_overlap_map(q->points[q->next]);
+		q->next = (q->next + 1) % q->point_count;
+	}
+}
+
+// Snapshots ---------------------------------------------------------------
+
+static void bench_snapshot_write(void* ctx, u32 ops)
+{
+	(void)ctx;
+	for (u32 i = 0; i < ops; ++i) {
+		emp_compressed_buffer snapshot = write_game_snapshot();
+		SDL_free(snapshot.data);
+	}
+}
+
+static void bench_snapshot_restore(void* ctx, u32 ops)
+{
+	emp_compressed_buffer* snapshot = ctx;
+	for (u32 i = 0; i < ops; ++i) {
+		restore_game_snapshot(*snapshot);
+	}
+}
+
+// Only the main-thread half: compression is left to the worker.
+static void bench_rewind_delta_capture(void* ctx, u32 ops)
+{
+	emp_rewind_t* rewind = ctx;
+	for (u32 i = 0; i < ops; ++i) {
+		emp_rewind_record(rewind);
+	}
+}
+
+static void bench_rewind_flush(void* ctx, u32 ops)
+{
+	(void)ops;
+	emp_rewind_flush(ctx);
+}
+
+static void bench_rewind_delta_record(void* ctx, u32 ops)
+{
+	emp_rewind_t* rewind = ctx;
+	for (u32 i = 0; i < ops; ++i) {
+		emp_rewind_record(rewind);
+		emp_rewind_flush(rewind);
+	}
+}
+
+static void bench_rewind_delta_restore(void* ctx, u32 ops)
+{
+	emp_rewind_t* rewind = ctx;
+	for (u32 i = 0; i < ops; ++i) {
+		emp_rewind_restore_latest(rewind);
+	}
+}
+
+// LDtk parsing ------------------------------------------------------------
+
+static void bench_ldtk_parse(void* ctx, u32 ops)
+{
+	emp_asset_t* source = ctx;
+	for (u32 i = 0; i < ops; ++i) {
+		emp_asset_t asset = *source;
+		asset.handle = NULL;
+		emp_load_level_asset(&asset);
+		emp_unload_level_asset(&asset);
+	}
+}
+
+// Headless loaders --------------------------------------------------------
+
+static void bench_png_load(emp_asset_t* asset)
+{
+	// Only sprite sizes matter to the simulation, and Florence's atlas region has them.
+	emp_texture_t* texture = SDL_malloc(sizeof(emp_texture_t));
+	SDL_zerop(texture);
+	if (asset->meta) {
+		emp_texture_from_region(texture, asset->meta);
+	}
+	asset->handle = texture;
+}
+
+static void bench_png_unload(emp_asset_t* asset)
+{
+	SDL_free(asset->handle);
+}
+
+static void bench_null_load(emp_asset_t* asset)
+{
+	asset->handle = NULL;
+}
+
+static void bench_null_unload(emp_asset_t* asset)
+{
+	(void)asset;
+}
+
+// Output ------------------------------------------------------------------
+
+static bool write_results(bench_t* bench, const char* out_path)
+{
+	u64 capacity = 256 + (u64)bench->result_count * 256;
+	char* json = SDL_malloc(capacity);
+	u64 len = 0;
+
+	len += SDL_snprintf(json + len, capacity - len, "{\n  \"seed\": %llu,\n  \"samples\": %u,\n  \"results\": [\n",
+		(unsigned long long)bench->seed, bench->samples);
+	for (u32 i = 0; i < bench->result_count; ++i) {
+		bench_result_t* r = &bench->results[i];
+		len += SDL_snprintf(json + len, capacity - len,
+			"    { \"name\": \"%s\", \"ops_per_sample\": %u, \"min_ns\": %.3f, \"median_ns\": %.3f, \"p99_ns\": %.3f }%s\n",
+			r->name, r->ops_per_sample, r->min_ns, r->median_ns, r->p99_ns, i + 1 < bench->result_count ? "," : "");
+	}
+	len += SDL_snprintf(json + len, capacity - len, "  ]\n}\n");
+
+	bool ok = true;
+	if (out_path) {
+		ok = SDL_SaveFile(out_path, json, len);
+		if (!ok) {
+			SDL_Log("Failed to write %s: %s", out_path, SDL_GetError());
+		}
+	} else {
+		fwrite(json, 1, len, stdout);
+	}
+	SDL_free(json);
+	return ok;
+}
+
+static const char* get_string_argument(int argc, char* argv[], const char* token)
+{
+	u64 token_len = SDL_strlen(token);
+	for (int index = 1; index < argc; index++) {
+		if (SDL_strncmp(argv[index], token, token_len) == 0) {
+			return argv[index] + token_len;
+		}
+	}
+	return NULL;
+}
+
+int main(int argc, char* argv[])
+{
+	if (!SDL_Init(0)) {
+		SDL_Log("Failed to initialize SDL: %s", SDL_GetError());
+		return 1;
+	}
+
+	const char* root = get_string_argument(argc, argv, "cwd=");
+	const char* seed = get_string_argument(argc, argv, "seed=");
+	const char* samples = get_string_argument(argc, argv, "samples=");
+	const char* out_path = get_string_argument(argc, argv, "out=");
+
+	bench_t bench = { 0 };
+	bench.seed = seed ? SDL_strtoull(seed, NULL, 10) : 1;
+	bench.samples = samples ? (u32)SDL_strtoul(samples, NULL, 10) : 200;
+	if (bench.samples == 0) {
+		bench.samples = 1;
+	}
+	bench.sample_ns = SDL_malloc(sizeof(double) * bench.samples);
+
+	emp_generated_assets_o* assets = emp_generated_assets_create(root ? root : "");
+	emp_asset_manager_o* asset_mgr = emp_asset_manager_create(assets);
+	emp_asset_manager_add_loader(asset_mgr, (emp_asset_loader_t) { .load = bench_png_load, .unload = bench_png_unload }, EMP_ASSET_TYPE_PNG);
+	emp_asset_manager_add_loader(asset_mgr, (emp_asset_loader_t) { .load = emp_load_level_asset, .unload = emp_unload_level_asset }, EMP_ASSET_TYPE_LDTK);
+	emp_asset_manager_add_loader(asset_mgr, (emp_asset_loader_t) { .load = bench_null_load, .unload = bench_null_unload }, EMP_ASSET_TYPE_OGG);
+	emp_asset_manager_load_all(asset_mgr);
+
+	G = SDL_malloc(sizeof(emp_G));
+	SDL_zerop(G);
+	G->assets = assets;
+	G->args = SDL_malloc(sizeof(emp_update_args_t));
+	SDL_zerop(G->args);
+	G->view_size = (emp_vec2_t) { .x = 1920.0f, .y = 1080.0f };
+
+	emp_entities_init();
+	emp_init_enemy_configs();
+	emp_init_weapon_configs();
+	emp_create_level(&G->assets->ldtk->world, 0);
+
+	SDL_Log("EmpireBench: seed %llu, %u samples", (unsigned long long)bench.seed, bench.samples);
+
+	// Bullet integration.
+	{
+		static const u32 counts[] = { 1000, 10000, 60000 };
+		static const char* names[] = { "bullet_integrate_1k", "bullet_integrate_10k", "bullet_integrate_60k" };
+		for (u32 i = 0; i < SDL_arraysize(counts); ++i) {
+			bench_reseed(&bench);
+			reset_entities();
+			spawn_random_bullets(counts[i], (emp_vec2_t) { 0.0f, 0.0f }, (emp_vec2_t) { 4096.0f, 4096.0f });
+			u32 count = counts[i];
+			bench_run(&bench, names[i], bench_bullet_integrate, &count, 16);
+		}
+	}
+
+	// Bullet vs enemy collision: the same 1024 px square at rising enemy counts,
+	// up to a full enemy pool (slot 0 is reserved).
+	{
+		static const u32 counts[] = { 16, 64, EMP_MAX_ENEMIES - 1 };
+		static const char* names[] = { "bullet_enemy_16", "bullet_enemy_64", "bullet_enemy_255" };
+		bench_collision_t collision = { .point_count = 4096 };
+		collision.points = SDL_malloc(sizeof(emp_vec2_t) * collision.point_count);
+		for (u32 i = 0; i < SDL_arraysize(counts); ++i) {
+			bench_reseed(&bench);
+			setup_enemy_field(counts[i], 1024.0f);
+			for (u32 p = 0; p < collision.point_count; ++p) {
+				collision.points[p] = (emp_vec2_t) { bench_rng_range(0.0f, 1024.0f), bench_rng_range(0.0f, 1024.0f) };
+			}
+			collision.next = 0;
+			bench_run(&bench, names[i], bench_bullet_enemy, &collision, collision.point_count);
+		}
+		SDL_free(collision.points);
+	}
+
+	// Bullet allocation churn on top of a steady population.
+	{
+		bench_reseed(&bench);
+		reset_entities();
+		spawn_random_bullets(8192, (emp_vec2_t) { 0.0f, 0.0f }, (emp_vec2_t) { 4096.0f, 4096.0f });
+
+		u32 batch = 1024;
+		bench_churn_t churn = {
+			.handles = SDL_malloc(sizeof(emp_bullet_h) * batch),
+			.order = SDL_malloc(sizeof(u32) * batch),
+		};
+		for (u32 i = 0; i < batch; ++i) {
+			churn.order[i] = i;
+		}
+		for (u32 i = batch - 1; i > 0; --i) {
+			u32 j = bench_rng() % (i + 1);
+			u32 tmp = churn.order[i];
+			churn.order[i] = churn.order[j];
+			churn.order[j] = tmp;
+		}
+		bench_run(&bench, "bullet_create_destroy", bench_bullet_churn, &churn, batch);
+		SDL_free(churn.handles);
+		SDL_free(churn.order);
+	}
+
+	// Level collision queries over the populated part of the level.
+	{
+		bench_reseed(&bench);
+		emp_level_asset_t* level = G->assets->ldtk->world.handle;
+		emp_vec2_t min = { SDL_MAX_SINT32, SDL_MAX_SINT32 };
+		emp_vec2_t max = { 0.0f, 0.0f };
+		for (u32 i = 0; i < level->sublevels.count; ++i) {
+			emp_sublevel_t* sublevel = &level->sublevels.entries[i];
+			emp_value_grid_t* grid = &sublevel->values;
+			min.x = SDL_min(min.x, sublevel->offset.x);
+			min.y = SDL_min(min.y, sublevel->offset.y);
+			max.x = SDL_max(max.x, sublevel->offset.x + grid->grid_width * grid->grid_size);
+			max.y = SDL_max(max.y, sublevel->offset.y + grid->grid_height * grid->grid_size);
+		}
+
+		bench_level_query_t query = { .point_count = 4096 };
+		query.points = SDL_malloc(sizeof(emp_vec2_t) * query.point_count);
+		for (u32 p = 0; p < query.point_count; ++p) {
+			query.points[p] = (emp_vec2_t) { bench_rng_range(min.x, max.x), bench_rng_range(min.y, max.y) };
+		}
+		bench_run(&bench, "level_overlap_query", bench_level_query, &query, query.point_count);
+		SDL_free(query.points);
+	}
+
+	// Snapshots of a busy frame: the level's own entities plus 10k bullets.
+	{
+		bench_reseed(&bench);
+		emp_create_level(&G->assets->ldtk->world, 1);
+		spawn_random_bullets(10000, (emp_vec2_t) { 0.0f, 0.0f }, (emp_vec2_t) { 4096.0f, 4096.0f });
+
+		bench_run(&bench, "snapshot_write", bench_snapshot_write, NULL, 1);
+
+		emp_compressed_buffer snapshot = write_game_snapshot();
+		bench_run(&bench, "snapshot_restore", bench_snapshot_restore, &snapshot, 1);
+		SDL_free(snapshot.data);
+
+		// Deltas against one keyframe, one step later; the keyframe interval
+		// is never reached.
+		emp_rewind_t rewind;
+		emp_rewind_init(&rewind, 64, SDL_MAX_UINT32);
+		emp_rewind_record(&rewind);
+		spawn_random_bullets(64, (emp_vec2_t) { 0.0f, 0.0f }, (emp_vec2_t) { 4096.0f, 4096.0f });
+		G->args->dt = BENCH_DT;
+		G->args->global_time += BENCH_DT;
+		emp_bullets_integrate(G->bullets, G->bullet_pool.count, BENCH_DT);
+		bench_run_with_setup(&bench, "rewind_delta_capture", bench_rewind_flush, bench_rewind_delta_capture, &rewind, 1);
+		bench_run(&bench, "rewind_delta_record", bench_rewind_delta_record, &rewind, 1);
+		bench_run(&bench, "rewind_delta_restore", bench_rewind_delta_restore, &rewind, 1);
+		emp_rewind_destroy(&rewind);
+	}
+
+	// LDtk parsing of the shipped world.
+	bench_run(&bench, "ldtk_parse_world", bench_ldtk_parse, &G->assets->ldtk->world, 1);
+
+	// The same world compiled the way packaged builds ship it. A packaged
+	// bench already loaded it compiled, so there is no JSON to compile.
+	{
+		emp_asset_t compiled = G->assets->ldtk->world;
+		compiled.data = emp_level_compile(compiled.data.data, (size_t)compiled.data.size);
+		if (compiled.data.data) {
+			bench_run(&bench, "level_load_compiled_world", bench_ldtk_parse, &compiled, 1);
+			SDL_free(compiled.data.data);
+		}
+	}
+
+	bool ok = write_results(&bench, out_path);
+
+	SDL_free(bench.sample_ns);
+	SDL_Quit();
+	return ok ? 0 : 1;
+}
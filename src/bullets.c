@@ -0,0 +1,131 @@
+#include "entities.h"
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_intrin.h>
+
+typedef void (*emp_bullets_integrate_f)(emp_bullets_t* bullets, u32 count, float dt);
+
+static emp_bullets_integrate_f integrate_impl;
+
+// All variants evaluate `life - dt` and `x + vx * dt` as separate float ops in
+// the same order, so every path produces bit-identical results.
+static void integrate_scalar(emp_bullets_t* bullets, u32 from, u32 count, float dt)
+{
+	float* x = bullets->x;
+	float* y = bullets->y;
+	float* vx = bullets->vx;
+	float* vy = bullets->vy;
+	float* life = bullets->life;
+
+	for (u32 i = from; i < count; ++i) {
+		life[i] -= dt;
+		x[i] += vx[i] * dt;
+		y[i] += vy[i] * dt;
+	}
+}
+
+static void emp_bullets_integrate_scalar(emp_bullets_t* bullets, u32 count, float dt)
+{
+	integrate_scalar(bullets, 0, count, dt);
+}
+
+#ifdef SDL_SSE2_INTRINSICS
+static void SDL_TARGETING("sse2") emp_bullets_integrate_sse2(emp_bullets_t* bullets, u32 count, float dt)
+{
+	__m128 dt4 = _mm_set1_ps(dt);
+	u32 wide = count & ~3u;
+
+	for (u32 i = 0; i < wide; i += 4) {
+		__m128 life = _mm_load_ps(bullets->life + i);
+		_mm_store_ps(bullets->life + i, _mm_sub_ps(life, dt4));
+
+		__m128 x = _mm_load_ps(bullets->x + i);
+		__m128 vx = _mm_load_ps(bullets->vx + i);
+		_mm_store_ps(bullets->x + i, _mm_add_ps(x, _mm_mul_ps(vx, dt4)));
+
+		__m128 y = _mm_load_ps(bullets->y + i);
+		__m128 vy = _mm_load_ps(bullets->vy + i);
+		_mm_store_ps(bullets->y + i, _mm_add_ps(y, _mm_mul_ps(vy, dt4)));
+	}
+
+	integrate_scalar(bullets, wide, count, dt);
+}
+#endif
+
+#ifdef SDL_AVX2_INTRINSICS
+static void SDL_TARGETING("avx2") emp_bullets_integrate_avx2(emp_bullets_t* bullets, u32 count, float dt)
+{
+	__m256 dt8 = _mm256_set1_ps(dt);
+	u32 wide = count & ~7u;
+
+	for (u32 i = 0; i < wide; i += 8) {
+		__m256 life = _mm256_load_ps(bullets->life + i);
+		_mm256_store_ps(bullets->life + i, _mm256_sub_ps(life, dt8));
+
+		__m256 x = _mm256_load_ps(bullets->x + i);
+		__m256 vx = _mm256_load_ps(bullets->vx + i);
+		_mm256_store_ps(bullets->x + i, _mm256_add_ps(x, _mm256_mul_ps(vx, dt8)));
+
+		__m256 y = _mm256_load_ps(bullets->y + i);
+		__m256 vy = _mm256_load_ps(bullets->vy + i);
+		_mm256_store_ps(bullets->y + i, _mm256_add_ps(y, _mm256_mul_ps(vy, dt8)));
+	}
+
+	integrate_scalar(bullets, wide, count, dt);
+}
+#endif
+
+static void* alloc_stream(u32 capacity, size_t element_size)
+{
+	size_t size = element_size * capacity;
+	void* data = SDL_aligned_alloc(32, size);
+	SDL_memset(data, 0, size);
+	return data;
+}
+
+void emp_bullets_init(emp_bullets_t* bullets, u32 capacity)
+{
+	bullets->x = alloc_stream(capacity, sizeof(*bullets->x));
+	bullets->y = alloc_stream(capacity, sizeof(*bullets->y));
+	bullets->px = alloc_stream(capacity, sizeof(*bullets->px));
+	bullets->py = alloc_stream(capacity, sizeof(*bullets->py));
+	bullets->vx = alloc_stream(capacity, sizeof(*bullets->vx));
+	bullets->vy = alloc_stream(capacity, sizeof(*bullets->vy));
+	bullets->life = alloc_stream(capacity, sizeof(*bullets->life));
+	bullets->damage = alloc_stream(capacity, sizeof(*bullets->damage));
+	bullets->mask = alloc_stream(capacity, sizeof(*bullets->mask));
+	bullets->texture_asset = alloc_stream(capacity, sizeof(*bullets->texture_asset));
+	bullets->custom_render = alloc_stream(capacity, sizeof(*bullets->custom_render));
+
+	integrate_impl = emp_bullets_integrate_scalar;
+#ifdef SDL_SSE2_INTRINSICS
+	if (SDL_HasSSE2()) {
+		integrate_impl = emp_bullets_integrate_sse2;
+	}
+#endif
+#ifdef SDL_AVX2_INTRINSICS
+	if (SDL_HasAVX2()) {
+		integrate_impl = emp_bullets_integrate_avx2;
+	}
+#endif
+}
+
+void emp_bullets_move(emp_bullets_t* bullets, u32 from, u32 to)
+{
+	bullets->x[to] = bullets->x[from];
+	bullets->y[to] = bullets->y[from];
+	bullets->px[to] = bullets->px[from];
+	bullets->py[to] = bullets->py[from];
+	bullets->vx[to] = bullets->vx[from];
+	bullets->vy[to] = bullets->vy[from];
+	bullets->life[to] = bullets->life[from];
+	bullets->damage[to] = bullets->damage[from];
+	bullets->mask[to] = bullets->mask[from];
+	bullets->texture_asset[to] = bullets->texture_asset[from];
+	bullets->custom_render[to] = bullets->custom_render[from];
+}
+
+void emp_bullets_integrate(emp_bullets_t* bullets, u32 count, float dt)
+{
+	integrate_impl(bullets, count, dt);
+}
@@ -1,12 +1,24 @@
 #include <SDL3/SDL.h>
+#include <Empire/atlas.h>
 #include <Empire/hash.inl>
+#include <Empire/level.h>
 #include <Empire/lz4.h>
+#include <Empire/package.h>
 #include <stdio.h>
 
 #define MAX_ASSETS 4096
 #define ASSETS_DIR "assets"
-
-static uint64_t g_total_uncompressed_size = 0;
+// Packaged and loose builds keep separate caches, since only one holds blocks.
+#ifdef FLORENCE_PACKAGE_ASSETS
+#define CACHE_PATH "src/generated/florence_package.cache"
+#else
+#define CACHE_PATH "src/generated/florence.cache"
+#endif
+#define CACHE_MAGIC 0x48434c46u // "FLCH"
+// Packaged levels are compiled, so a new level format also invalidates it.
+#define CACHE_VERSION (3 << 8 | EMP_LEVEL_VERSION)
+// Images larger than a page (with padding) get a page of their own.
+#define ATLAS_PAGE_SIZE 1024
 
 typedef struct {
     char* name;
@@ -15,8 +27,41 @@ typedef struct {
     uint64_t hash;
     uint64_t offset;
     uint64_t size;
+    uint64_t compressed_size;
+    // Cache key: the file's modify time and size when it was last hashed.
+    int64_t modify_time;
+    uint64_t file_size;
+    // Set when the cache had this file, so it is not read again.
+    int cached;
+    // Set when the previous assets.bin already holds this file's block at `offset`.
+    int block_cached;
+    // The block to write, for files read this run.
+    void* block;
+    // PNGs only: image size from the header and place in the atlas.
+    uint32_t width;
+    uint32_t height;
+    uint32_t atlas_page;
+    uint32_t atlas_x;
+    uint32_t atlas_y;
 } Asset;
 
+// One record per asset in CACHE_PATH, followed by its path.
+typedef struct {
+    int64_t modify_time;
+    uint64_t file_size;
+    uint64_t hash;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t compressed_size;
+    uint32_t width;
+    uint32_t height;
+    uint32_t packaged;
+    uint32_t path_len;
+} CacheRecord;
+
+static emp_atlas_page_desc_t g_atlas_pages[MAX_ASSETS];
+static int g_atlas_page_count = 0;
+
 static char* to_snake_case(const char* filename) {
     char* result = SDL_strdup(filename);
     for (char* p = result; *p; p++) {
@@ -26,6 +71,15 @@ static char* to_snake_case(const char* filename) {
     return result;
 }
 
+// Music is streamed while it plays, so in file mode it is not read up front.
+static int is_streamed(const Asset* asset) {
+    const char* suffix = "_music_loopable";
+    size_t name_len = SDL_strlen(asset->name);
+    size_t suffix_len = SDL_strlen(suffix);
+    return SDL_strcmp(asset->ext, "ogg") == 0 && name_len >= suffix_len &&
+        SDL_strcmp(asset->name + name_len - suffix_len, suffix) == 0;
+}
+
 static void upper_ext(const char* ext, char* buf)
 {
     for (const char* p = ext; *p; p++, buf++) {
@@ -71,7 +125,8 @@ static uint64_t compute_output_checksum(const char* header_path, const char* sou
                 size_t line_len = line_end - pos;
                 if (line_len < sizeof(saved)) {
                     SDL_memcpy(saved, pos, line_len);
-                    SDL_memcpy(pos, "#define GENERATED_OUTPUT_CHECKSUM 0x0000000000000000ULL", 57);
+                    const char placeholder[] = "#define GENERATED_OUTPUT_CHECKSUM 0x0000000000000000ULL";
+                    SDL_memcpy(pos, placeholder, sizeof(placeholder) - 1);
                 }
             }
         }
@@ -208,15 +263,24 @@ static int scan_directory(const char* dir, Asset* assets, int* count) {
         // Get extension
         asset->ext = SDL_strdup(dot + 1);
         
-        // Compute hash
-        size_t file_size = 0;
-        void* file_data = SDL_LoadFile(asset->path, &file_size);
-        if (file_data) {
-            asset->hash = hash_murmur3((const uint8_t*)file_data, file_size);
-            SDL_free(file_data);
-        } else {
-            asset->hash = 0;
+        // Hashed later, from the cache or by the workers
+        SDL_PathInfo info;
+        if (SDL_GetPathInfo(asset->path, &info)) {
+            asset->modify_time = info.modify_time;
+            asset->file_size = info.size;
         }
+        asset->hash = 0;
+        asset->offset = 0;
+        asset->size = 0;
+        asset->compressed_size = 0;
+        asset->cached = 0;
+        asset->block_cached = 0;
+        asset->block = NULL;
+        asset->width = 0;
+        asset->height = 0;
+        asset->atlas_page = 0;
+        asset->atlas_x = 0;
+        asset->atlas_y = 0;
         
         (*count)++;
     }
@@ -224,6 +288,334 @@ static int scan_directory(const char* dir, Asset* assets, int* count) {
     return 1;
 }
 
+static void load_cache(Asset* assets, int count) {
+    size_t cache_size = 0;
+    uint8_t* cache = (uint8_t*)SDL_LoadFile(CACHE_PATH, &cache_size);
+    if (!cache) return;
+    
+    uint32_t header[3];
+    if (cache_size < sizeof(header)) {
+        SDL_free(cache);
+        return;
+    }
+    SDL_memcpy(header, cache, sizeof(header));
+    if (header[0] != CACHE_MAGIC || header[1] != CACHE_VERSION) {
+        SDL_free(cache);
+        return;
+    }
+    
+    int hits = 0;
+    size_t at = sizeof(header);
+    for (uint32_t r = 0; r < header[2]; r++) {
+        CacheRecord record;
+        if (at + sizeof(record) > cache_size) break;
+        SDL_memcpy(&record, cache + at, sizeof(record));
+        at += sizeof(record);
+        if (at + record.path_len > cache_size) break;
+        const char* path = (const char*)cache + at;
+        at += record.path_len;
+        
+        for (int i = 0; i < count; i++) {
+            Asset* asset = &assets[i];
+            if (asset->cached || SDL_strlen(asset->path) != record.path_len ||
+                SDL_strncmp(asset->path, path, record.path_len) != 0) {
+                continue;
+            }
+            if (asset->modify_time == record.modify_time && asset->file_size == record.file_size) {
+                asset->cached = 1;
+                asset->hash = record.hash;
+                asset->width = record.width;
+                asset->height = record.height;
+#ifdef FLORENCE_PACKAGE_ASSETS
+                asset->block_cached = record.packaged;
+                asset->offset = record.offset;
+                asset->size = record.size;
+                asset->compressed_size = record.compressed_size;
+#endif
+                hits++;
+            }
+            break;
+        }
+    }
+    SDL_free(cache);
+    printf("Cache: %d of %d assets unchanged\n", hits, count);
+}
+
+static void save_cache(Asset* assets, int count) {
+    SDL_IOStream* f = SDL_IOFromFile(CACHE_PATH, "wb");
+    if (!f) return;
+    
+    uint32_t header[3] = { CACHE_MAGIC, CACHE_VERSION, (uint32_t)count };
+    SDL_WriteIO(f, header, sizeof(header));
+    for (int i = 0; i < count; i++) {
+        CacheRecord record = {
+            .modify_time = assets[i].modify_time,
+            .file_size = assets[i].file_size,
+            .hash = assets[i].hash,
+            .offset = assets[i].offset,
+            .size = assets[i].size,
+            .compressed_size = assets[i].compressed_size,
+            .width = assets[i].width,
+            .height = assets[i].height,
+#ifdef FLORENCE_PACKAGE_ASSETS
+            .packaged = (uint32_t)assets[i].block_cached,
+#endif
+            .path_len = (uint32_t)SDL_strlen(assets[i].path),
+        };
+        SDL_WriteIO(f, &record, sizeof(record));
+        SDL_WriteIO(f, assets[i].path, record.path_len);
+    }
+    SDL_CloseIO(f);
+}
+
+#ifdef FLORENCE_PACKAGE_ASSETS
+// The entry table of the previous assets.bin, or NULL with `*entry_count` 0
+// when there is none.
+static emp_package_entry_t* read_package_entries(uint32_t* entry_count) {
+    SDL_IOStream* f = SDL_IOFromFile("assets.bin", "rb");
+    emp_package_header_t header = { 0 };
+    emp_package_entry_t* entries = NULL;
+    *entry_count = 0;
+    if (f && SDL_ReadIO(f, &header, sizeof(header)) == sizeof(header) &&
+        header.magic == EMP_PACKAGE_MAGIC && header.version == EMP_PACKAGE_VERSION) {
+        entries = (emp_package_entry_t*)SDL_malloc(sizeof(emp_package_entry_t) * header.count);
+        if (SDL_ReadIO(f, entries, sizeof(emp_package_entry_t) * header.count) == sizeof(emp_package_entry_t) * header.count) {
+            *entry_count = header.count;
+        }
+    }
+    if (f) SDL_CloseIO(f);
+    return entries;
+}
+
+// Cached blocks are copied out of the previous assets.bin, so they are only
+// usable if it still holds an entry with the same offset and hash.
+static void check_cached_blocks(Asset* assets, int count) {
+    uint32_t entry_count;
+    emp_package_entry_t* entries = read_package_entries(&entry_count);
+    for (int i = 0; i < count; i++) {
+        if (!assets[i].block_cached) continue;
+        int found = 0;
+        for (uint32_t e = 0; e < entry_count; e++) {
+            if (entries[e].offset == assets[i].offset && entries[e].hash == assets[i].hash) {
+                found = 1;
+                break;
+            }
+        }
+        if (!found) {
+            // Still hashed, but read again to rebuild the block.
+            assets[i].cached = 0;
+            assets[i].block_cached = 0;
+        }
+    }
+    SDL_free(entries);
+}
+
+// A file that was touched but not changed hashes the same as its entry in
+// assets.bin. When this run did not rewrite the package, pointing it back at
+// that entry keeps its cache record usable.
+static void match_package_entries(Asset* assets, int count) {
+    uint32_t entry_count;
+    emp_package_entry_t* entries = read_package_entries(&entry_count);
+    for (int i = 0; i < count; i++) {
+        if (assets[i].block_cached || !assets[i].block) continue;
+        for (uint32_t e = 0; e < entry_count; e++) {
+            if (entries[e].hash == assets[i].hash) {
+                assets[i].offset = entries[e].offset;
+                assets[i].size = entries[e].size;
+                assets[i].compressed_size = entries[e].compressed_size;
+                assets[i].block_cached = 1;
+                break;
+            }
+        }
+    }
+    SDL_free(entries);
+}
+
+// Stores the file raw when LZ4 does not shrink it (OGG is already compressed).
+static void compress_block(Asset* asset, void* data, size_t file_size) {
+    int max_compressed = LZ4_compressBound((int)file_size);
+    char* compressed = (char*)SDL_malloc(max_compressed);
+    int compressed_size = LZ4_compress_default((const char*)data, compressed, (int)file_size, max_compressed);
+    if (compressed_size > 0 && (size_t)compressed_size < file_size && SDL_strcmp(asset->ext, "ogg") != 0) {
+        SDL_free(data);
+        asset->block = compressed;
+        asset->compressed_size = (uint64_t)compressed_size;
+    } else {
+        SDL_free(compressed);
+        asset->block = data;
+        asset->compressed_size = 0;
+    }
+}
+#endif
+
+// Reads each file once: hashes it and, when packaging, compresses its block.
+// Levels are packaged compiled rather than as JSON.
+static void process_asset(Asset* asset) {
+    size_t file_size = 0;
+    void* data = SDL_LoadFile(asset->path, &file_size);
+    if (!data) {
+        SDL_Log("Failed to read %s", asset->path);
+        asset->hash = 0;
+        return;
+    }
+    asset->hash = hash_murmur3((const uint8_t*)data, file_size);
+    asset->size = file_size;
+    // The size is in the IHDR chunk right after the 8-byte signature.
+    const uint8_t* bytes = (const uint8_t*)data;
+    if (SDL_strcmp(asset->ext, "png") == 0 && file_size >= 24 && SDL_memcmp(bytes + 12, "IHDR", 4) == 0) {
+        asset->width = ((uint32_t)bytes[16] << 24) | ((uint32_t)bytes[17] << 16) | ((uint32_t)bytes[18] << 8) | bytes[19];
+        asset->height = ((uint32_t)bytes[20] << 24) | ((uint32_t)bytes[21] << 16) | ((uint32_t)bytes[22] << 8) | bytes[23];
+    }
+#ifdef FLORENCE_PACKAGE_ASSETS
+    if (SDL_strcmp(asset->ext, "ldtk") == 0) {
+        emp_buffer level = emp_level_compile(data, file_size);
+        if (level.data) {
+            SDL_free(data);
+            data = level.data;
+            file_size = (size_t)level.size;
+            asset->size = level.size;
+        } else {
+            // Left without a block, which fails the package.
+            SDL_Log("Failed to compile %s", asset->path);
+            SDL_free(data);
+            return;
+        }
+    }
+    compress_block(asset, data, file_size);
+#else
+    SDL_free(data);
+#endif
+}
+
+typedef struct {
+    Asset* assets;
+    int count;
+    SDL_AtomicInt next;
+} Work;
+
+static int SDLCALL worker(void* data) {
+    Work* work = (Work*)data;
+    for (;;) {
+        int i = SDL_AddAtomicInt(&work->next, 1);
+        if (i >= work->count) break;
+        if (!work->assets[i].cached) {
+            process_asset(&work->assets[i]);
+        }
+    }
+    return 0;
+}
+
+// Processes every asset the cache missed, one thread per core.
+static void process_assets(Asset* assets, int count) {
+    int missed = 0;
+    for (int i = 0; i < count; i++) {
+        if (!assets[i].cached) missed++;
+    }
+    if (missed == 0) return;
+    
+    Work work = { .assets = assets, .count = count };
+    SDL_SetAtomicInt(&work.next, 0);
+    int thread_count = SDL_min(SDL_GetNumLogicalCPUCores(), missed);
+    SDL_Thread** threads = (SDL_Thread**)SDL_calloc(thread_count, sizeof(SDL_Thread*));
+    for (int t = 0; t < thread_count; t++) {
+        threads[t] = SDL_CreateThread(worker, "florence_worker", &work);
+    }
+    // Also covers the case where no thread could be started.
+    worker(&work);
+    for (int t = 0; t < thread_count; t++) {
+        if (threads[t]) SDL_WaitThread(threads[t], NULL);
+    }
+    SDL_free(threads);
+    printf("Read %d assets on %d threads\n", missed, thread_count);
+}
+
+// Sprite sheets are named like `enemy1_32.png`: square frames of 32 texels.
+static uint32_t frame_size_from_path(const char* path) {
+    const char* dot = SDL_strrchr(path, '.');
+    const char* underscore = SDL_strrchr(path, '_');
+    const char* slash = SDL_strrchr(path, '/');
+    if (underscore && (!dot || underscore < dot) && (!slash || underscore > slash)) {
+        return (uint32_t)SDL_atoi(underscore + 1);
+    }
+    return 0;
+}
+
+static int is_atlas_image(const Asset* asset) {
+    return SDL_strcmp(asset->ext, "png") == 0 && asset->width > 0 && asset->height > 0;
+}
+
+static int compare_atlas_images(void* userdata, const void* a, const void* b) {
+    const Asset* assets = (const Asset*)userdata;
+    const Asset* left = &assets[*(const int*)a];
+    const Asset* right = &assets[*(const int*)b];
+    if (left->height != right->height) return left->height > right->height ? -1 : 1;
+    if (left->width != right->width) return left->width > right->width ? -1 : 1;
+    return *(const int*)a - *(const int*)b;
+}
+
+static int add_atlas_page(uint32_t width, uint32_t height) {
+    g_atlas_pages[g_atlas_page_count] = (emp_atlas_page_desc_t) { .width = width, .height = height, .region_count = 0 };
+    return g_atlas_page_count++;
+}
+
+// Regions are written in asset order, skipping everything but images.
+static int atlas_region_index(const Asset* assets, int asset_index) {
+    int index = 0;
+    for (int i = 0; i < asset_index; i++) {
+        if (is_atlas_image(&assets[i])) index++;
+    }
+    return index;
+}
+
+// Shelf packer: images go tallest first into rows left to right, and a row
+// is as tall as its first image. Pages are trimmed to what they use.
+static void pack_atlas(Asset* assets, int count) {
+    int* order = (int*)SDL_malloc(sizeof(int) * (count > 0 ? count : 1));
+    int image_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (is_atlas_image(&assets[i])) order[image_count++] = i;
+    }
+    SDL_qsort_r(order, image_count, sizeof(int), compare_atlas_images, assets);
+    
+    g_atlas_page_count = 0;
+    int shared = -1;
+    uint32_t shelf_x = 0, shelf_y = 0, shelf_height = 0;
+    for (int n = 0; n < image_count; n++) {
+        Asset* asset = &assets[order[n]];
+        uint32_t padded_width = asset->width + EMP_ATLAS_PADDING * 2;
+        uint32_t padded_height = asset->height + EMP_ATLAS_PADDING * 2;
+        
+        if (padded_width > ATLAS_PAGE_SIZE || padded_height > ATLAS_PAGE_SIZE) {
+            asset->atlas_page = (uint32_t)add_atlas_page(padded_width, padded_height);
+            asset->atlas_x = EMP_ATLAS_PADDING;
+            asset->atlas_y = EMP_ATLAS_PADDING;
+            g_atlas_pages[asset->atlas_page].region_count++;
+            continue;
+        }
+        if (shelf_x + padded_width > ATLAS_PAGE_SIZE) {
+            shelf_y += shelf_height;
+            shelf_x = 0;
+            shelf_height = 0;
+        }
+        if (shared < 0 || shelf_y + padded_height > ATLAS_PAGE_SIZE) {
+            shared = add_atlas_page(0, 0);
+            shelf_x = shelf_y = shelf_height = 0;
+        }
+        
+        emp_atlas_page_desc_t* page = &g_atlas_pages[shared];
+        asset->atlas_page = (uint32_t)shared;
+        asset->atlas_x = shelf_x + EMP_ATLAS_PADDING;
+        asset->atlas_y = shelf_y + EMP_ATLAS_PADDING;
+        page->region_count++;
+        shelf_x += padded_width;
+        shelf_height = SDL_max(shelf_height, padded_height);
+        page->width = SDL_max(page->width, shelf_x);
+        page->height = SDL_max(page->height, shelf_y + padded_height);
+    }
+    SDL_free(order);
+    printf("Packed %d images onto %d atlas pages\n", image_count, g_atlas_page_count);
+}
+
 static void write_header(Asset* assets, int count, uint64_t checksum) {
     SDL_CreateDirectory("include/Empire/generated");
     SDL_IOStream* f = SDL_IOFromFile("include/Empire/generated/assets_generated.h", "w");
@@ -233,14 +625,14 @@ static void write_header(Asset* assets, int count, uint64_t checksum) {
     }
     
     SDL_IOprintf(f, "#pragma once\n");
-    SDL_IOprintf(f, "#include \"../assets.h\"\n\n");
+    SDL_IOprintf(f, "#include \"../assets.h\"\n");
+    SDL_IOprintf(f, "#include \"../atlas.h\"\n\n");
     SDL_IOprintf(f, "// Auto-generated file. Do not edit.\n\n");
     SDL_IOprintf(f, "#define GENERATED_ASSETS_CHECKSUM 0x%016llxULL\n", (unsigned long long)checksum);
     SDL_IOprintf(f, "#define GENERATED_OUTPUT_CHECKSUM 0x0000000000000000ULL\n\n");
     
 #ifdef FLORENCE_PACKAGE_ASSETS
-    SDL_IOprintf(f, "#define FLORENCE_PACKAGE_ASSETS 1\n");
-    SDL_IOprintf(f, "#define PACKAGED_UNCOMPRESSED_SIZE %lluULL\n\n", (unsigned long long)g_total_uncompressed_size);
+    SDL_IOprintf(f, "#define FLORENCE_PACKAGE_ASSETS 1\n\n");
 #endif
     
     for (int ext_pass = 0; ext_pass < count; ext_pass++) {
@@ -297,11 +689,11 @@ static void write_header(Asset* assets, int count, uint64_t checksum) {
         SDL_IOprintf(f, "    emp_generated_%s_t* %s;\n", current_ext, current_ext);
     }
     
-#ifdef FLORENCE_PACKAGE_ASSETS
-    SDL_IOprintf(f, "    u8* packaged_blob;\n");
-#endif
     SDL_IOprintf(f, "} emp_generated_assets_o;\n\n");
+    SDL_IOprintf(f, "#define EMP_ATLAS_PAGE_COUNT %d\n", g_atlas_page_count);
+    SDL_IOprintf(f, "extern const emp_atlas_page_desc_t emp_atlas_pages[];\n\n");
     SDL_IOprintf(f, "emp_generated_assets_o* emp_generated_assets_create(const char* root);\n");
+    SDL_IOprintf(f, "void emp_generated_assets_destroy(emp_generated_assets_o* assets);\n");
     
     SDL_CloseIO(f);
 }
@@ -319,22 +711,47 @@ static void write_source(Asset* assets, int count) {
     SDL_IOprintf(f, "// Auto-generated file. Do not edit.\n\n");
     SDL_IOprintf(f, "#include <SDL3/SDL.h>\n");
 #ifdef FLORENCE_PACKAGE_ASSETS
-    SDL_IOprintf(f, "#include <Empire/lz4.h>\n");
+    SDL_IOprintf(f, "#include <Empire/package.h>\n");
 #endif
     SDL_IOprintf(f, "\n");
+#ifdef FLORENCE_PACKAGE_ASSETS
+    SDL_IOprintf(f, "static emp_package_t g_package;\n\n");
+#endif
+    
+    SDL_IOprintf(f, "const emp_atlas_page_desc_t emp_atlas_pages[] = {\n");
+    for (int p = 0; p < g_atlas_page_count; p++) {
+        SDL_IOprintf(f, "    { %u, %u, %u },\n", g_atlas_pages[p].width, g_atlas_pages[p].height, g_atlas_pages[p].region_count);
+    }
+    if (g_atlas_page_count == 0) {
+        SDL_IOprintf(f, "    { 0 },\n");
+    }
+    SDL_IOprintf(f, "};\n\n");
+    
+    SDL_IOprintf(f, "static const emp_atlas_region_t g_atlas_regions[] = {\n");
+    int region_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (!is_atlas_image(&assets[i])) continue;
+        uint32_t frame_size = frame_size_from_path(assets[i].path);
+        uint32_t columns = frame_size ? assets[i].width / frame_size : 1;
+        uint32_t rows = frame_size ? assets[i].height / frame_size : 1;
+        SDL_IOprintf(f, "    { %u, %u, %u, %u, %u, %u, %u, %u }, // %s\n",
+            assets[i].atlas_page, assets[i].atlas_x, assets[i].atlas_y, assets[i].width, assets[i].height,
+            frame_size, columns, rows, assets[i].name);
+        region_count++;
+    }
+    if (region_count == 0) {
+        SDL_IOprintf(f, "    { 0 },\n");
+    }
+    SDL_IOprintf(f, "};\n\n");
     
     SDL_IOprintf(f, "emp_generated_assets_o* emp_generated_assets_create(const char* root) {\n");
     SDL_IOprintf(f, "    emp_generated_assets_o* assets = (emp_generated_assets_o*)SDL_malloc(sizeof(emp_generated_assets_o));\n");
     SDL_IOprintf(f, "    SDL_memset(assets, 0, sizeof(emp_generated_assets_o));\n\n");
 
 #ifdef FLORENCE_PACKAGE_ASSETS
-    SDL_IOprintf(f, "    size_t compressed_size = 0;\n");
     SDL_IOprintf(f, "    const char* pkg_path = emp_concat(root, \"assets.bin\");\n");
-    SDL_IOprintf(f, "    void* compressed = SDL_LoadFile(pkg_path, &compressed_size);\n");
-    SDL_IOprintf(f, "    SDL_free((void*)pkg_path);\n");
-    SDL_IOprintf(f, "    assets->packaged_blob = (u8*)SDL_malloc(PACKAGED_UNCOMPRESSED_SIZE);\n");
-    SDL_IOprintf(f, "    LZ4_decompress_safe((const char*)compressed, (char*)assets->packaged_blob, (int)compressed_size, (int)PACKAGED_UNCOMPRESSED_SIZE);\n");
-    SDL_IOprintf(f, "    SDL_free(compressed);\n\n");
+    SDL_IOprintf(f, "    emp_package_open(&g_package, pkg_path);\n");
+    SDL_IOprintf(f, "    SDL_free((void*)pkg_path);\n\n");
 #endif
     
     for (int ext_pass = 0; ext_pass < count; ext_pass++) {
@@ -385,73 +802,143 @@ static void write_source(Asset* assets, int count) {
 #ifdef FLORENCE_PACKAGE_ASSETS
                 SDL_IOprintf(f, "    assets->%s->%s.path = \"%s\";\n", 
                     current_ext, assets[i].name, assets[i].path);
-                SDL_IOprintf(f, "    assets->%s->%s.data.data = assets->packaged_blob + %lluULL;\n",
-                    current_ext, assets[i].name, (unsigned long long)assets[i].offset);
-                SDL_IOprintf(f, "    assets->%s->%s.data.size = %lluULL;\n",
-                    current_ext, assets[i].name, (unsigned long long)assets[i].size);
+                SDL_IOprintf(f, "    emp_package_bind(&g_package, &assets->%s->%s, %d);\n",
+                    current_ext, assets[i].name, i);
 #else
                 SDL_IOprintf(f, "    assets->%s->%s.path = emp_concat(root, \"%s\");\n", 
                     current_ext, assets[i].name, assets[i].path);
-                SDL_IOprintf(f, "    assets->%s->%s.data = emp_read_entire_file(assets->%s->%s.path);\n",
-                    current_ext, assets[i].name, current_ext, assets[i].name);
+                if (!is_streamed(&assets[i])) {
+                    SDL_IOprintf(f, "    assets->%s->%s.data = emp_read_entire_file(assets->%s->%s.path);\n",
+                        current_ext, assets[i].name, current_ext, assets[i].name);
+                }
 #endif
                 SDL_IOprintf(f, "    assets->%s->%s.hash = 0x%016llxULL;\n", 
                     current_ext, assets[i].name, (unsigned long long)assets[i].hash);
+                if (is_atlas_image(&assets[i])) {
+                    SDL_IOprintf(f, "    assets->%s->%s.meta = &g_atlas_regions[%d];\n",
+                        current_ext, assets[i].name, atlas_region_index(assets, i));
+                }
                 SDL_IOprintf(f, "\n");
             }
         }
     }
     
     SDL_IOprintf(f, "    return assets;\n");
+    SDL_IOprintf(f, "}\n\n");
+    
+    // Asset data belongs to the asset manager by now; only the tables and the
+    // package mapping are released here.
+    SDL_IOprintf(f, "void emp_generated_assets_destroy(emp_generated_assets_o* assets) {\n");
+    for (int ext_pass = 0; ext_pass < count; ext_pass++) {
+        const char* current_ext = assets[ext_pass].ext;
+        int already_written = 0;
+        
+        for (int i = 0; i < ext_pass; i++) {
+            if (SDL_strcmp(assets[i].ext, current_ext) == 0) {
+                already_written = 1;
+                break;
+            }
+        }
+        if (already_written) continue;
+        
+        SDL_IOprintf(f, "    SDL_free(assets->%s);\n", current_ext);
+    }
+    SDL_IOprintf(f, "    SDL_free(assets);\n");
+#ifdef FLORENCE_PACKAGE_ASSETS
+    SDL_IOprintf(f, "    emp_package_close(&g_package);\n");
+#endif
     SDL_IOprintf(f, "}\n");
     
     SDL_CloseIO(f);
 }
 
 #ifdef FLORENCE_PACKAGE_ASSETS
-static void write_package(Asset* assets, int count) {
+// Writes the header, the entry table and one block per asset. Blocks of
+// unchanged assets are copied from the previous package, so the new one is
+// written next to it and renamed over it at the end. Any asset without data
+// or any failed write fails the build and leaves the old package in place.
+static int write_package(Asset* assets, int count) {
+    SDL_IOStream* previous = SDL_IOFromFile("assets.bin", "rb");
+    SDL_IOStream* f = SDL_IOFromFile("assets.bin.tmp", "wb");
+    if (!f) {
+        SDL_Log("Failed to open assets.bin.tmp for writing");
+        if (previous) SDL_CloseIO(previous);
+        return 0;
+    }
+    
+    emp_package_entry_t* entries = (emp_package_entry_t*)SDL_calloc(count, sizeof(emp_package_entry_t));
+    uint64_t offset = sizeof(emp_package_header_t) + sizeof(emp_package_entry_t) * (uint64_t)count;
     uint64_t total_size = 0;
-    for (int i = 0; i < count; i++) {
-        size_t file_size = 0;
-        void* data = SDL_LoadFile(assets[i].path, &file_size);
-        if (data) {
-            assets[i].offset = total_size;
-            assets[i].size = file_size;
-            total_size += file_size;
-            SDL_free(data);
+    int ok = 1;
+    
+    for (int i = 0; i < count && ok; i++) {
+        Asset* asset = &assets[i];
+        // Stored blocks are used in place, so they start 8-byte aligned.
+        offset = (offset + 7) & ~(uint64_t)7;
+        SDL_SeekIO(f, (Sint64)offset, SDL_IO_SEEK_SET);
+        uint64_t block_size = asset->compressed_size ? asset->compressed_size : asset->size;
+        void* block = asset->block;
+        if (!block && asset->block_cached && previous) {
+            block = SDL_malloc(block_size);
+            if (SDL_SeekIO(previous, (Sint64)asset->offset, SDL_IO_SEEK_SET) < 0 ||
+                SDL_ReadIO(previous, block, block_size) != block_size) {
+                SDL_free(block);
+                block = NULL;
+            }
+        }
+        if (!block) {
+            SDL_Log("No data for %s, not writing the package", asset->path);
+            asset->block_cached = 0;
+            asset->cached = 0;
+            ok = 0;
+            break;
+        }
+        if (SDL_WriteIO(f, block, block_size) != block_size) {
+            SDL_Log("Failed to write %s to the package: %s", asset->path, SDL_GetError());
+            ok = 0;
         }
+        if (block != asset->block) SDL_free(block);
+        if (!ok) break;
+        
+        asset->offset = offset;
+        asset->block_cached = 1;
+        entries[i].offset = offset;
+        entries[i].compressed_size = asset->compressed_size;
+        entries[i].size = asset->size;
+        entries[i].hash = asset->hash;
+        offset += block_size;
+        total_size += asset->size;
     }
     
-    g_total_uncompressed_size = total_size;
-    
-    uint8_t* blob = (uint8_t*)SDL_malloc(total_size);
-    uint64_t write_offset = 0;
-    
-    for (int i = 0; i < count; i++) {
-        size_t file_size = 0;
-        void* data = SDL_LoadFile(assets[i].path, &file_size);
-        if (data) {
-            SDL_memcpy(blob + write_offset, data, file_size);
-            write_offset += file_size;
-            SDL_free(data);
+    if (ok) {
+        emp_package_header_t header = { .magic = EMP_PACKAGE_MAGIC, .version = EMP_PACKAGE_VERSION, .count = (u32)count };
+        size_t table_size = sizeof(emp_package_entry_t) * count;
+        if (SDL_SeekIO(f, 0, SDL_IO_SEEK_SET) < 0 ||
+            SDL_WriteIO(f, &header, sizeof(header)) != sizeof(header) ||
+            SDL_WriteIO(f, entries, table_size) != table_size) {
+            SDL_Log("Failed to write the package table: %s", SDL_GetError());
+            ok = 0;
         }
     }
-    
-    int max_compressed = LZ4_compressBound((int)total_size);
-    char* compressed = (char*)SDL_malloc(max_compressed);
-    int compressed_size = LZ4_compress_default((const char*)blob, compressed, (int)total_size, max_compressed);
-    
-    SDL_IOStream* f = SDL_IOFromFile("assets.bin", "wb");
-    if (f) {
-        SDL_WriteIO(f, compressed, compressed_size);
-        SDL_CloseIO(f);
-        printf("Packaged %d assets: %llu bytes -> %d bytes (%.1f%%)\n", 
-            count, (unsigned long long)total_size, compressed_size, 
-            100.0f * compressed_size / total_size);
+    if (!SDL_CloseIO(f)) {
+        SDL_Log("Failed to finish assets.bin.tmp: %s", SDL_GetError());
+        ok = 0;
     }
+    if (previous) SDL_CloseIO(previous);
+    SDL_free(entries);
     
-    SDL_free(blob);
-    SDL_free(compressed);
+    if (!ok) {
+        SDL_RemovePath("assets.bin.tmp");
+        return 0;
+    }
+    if (!SDL_RenamePath("assets.bin.tmp", "assets.bin")) {
+        SDL_Log("Failed to replace assets.bin: %s", SDL_GetError());
+        return 0;
+    }
+    printf("Packaged %d assets: %llu bytes -> %llu bytes (%.1f%%)\n",
+        count, (unsigned long long)total_size, (unsigned long long)offset,
+        100.0f * offset / total_size);
+    return 1;
 }
 #endif
 
@@ -477,34 +964,59 @@ int main(int argc, char* argv[]) {
     const char* header_path = "include/Empire/generated/assets_generated.h";
     const char* source_path = "src/generated/assets_generated.c";
     
+    load_cache(assets, count);
+#ifdef FLORENCE_PACKAGE_ASSETS
+    check_cached_blocks(assets, count);
+#endif
+    process_assets(assets, count);
+    
     uint64_t new_input_checksum = compute_assets_checksum(assets, count);
     
-    if (!needs_regeneration(new_input_checksum, header_path, source_path)) {
-        for (int i = 0; i < count; i++) {
-            SDL_free(assets[i].name);
-            SDL_free(assets[i].ext);
-            SDL_free(assets[i].path);
-        }
-        SDL_Quit();
-        return 0;
+    int regenerate = needs_regeneration(new_input_checksum, header_path, source_path);
+#ifdef FLORENCE_PACKAGE_ASSETS
+    SDL_PathInfo package_info;
+    if (!regenerate && !SDL_GetPathInfo("assets.bin", &package_info)) {
+        printf("assets.bin is missing, regenerating...\n");
+        regenerate = 1;
     }
+#endif
     
-    printf("Generating assets (input checksum: 0x%016llx)...\n", (unsigned long long)new_input_checksum);
-    
+    if (regenerate) {
+        printf("Generating assets (input checksum: 0x%016llx)...\n", (unsigned long long)new_input_checksum);
+        
+        pack_atlas(assets, count);        
 #ifdef FLORENCE_PACKAGE_ASSETS
-    write_package(assets, count);
+        if (!write_package(assets, count)) {
+            SDL_Log("Failed to write assets.bin");
+            for (int i = 0; i < count; i++) {
+                SDL_free(assets[i].name);
+                SDL_free(assets[i].ext);
+                SDL_free(assets[i].path);
+                SDL_free(assets[i].block);
+            }
+            SDL_Quit();
+            return 1;
+        }
 #endif
-    write_header(assets, count, new_input_checksum);
-    write_source(assets, count);
-    update_output_checksum(header_path, source_path);
+        write_header(assets, count, new_input_checksum);
+        write_source(assets, count);
+        update_output_checksum(header_path, source_path);
+    }
+#ifdef FLORENCE_PACKAGE_ASSETS
+    match_package_entries(assets, count);
+#endif
+    save_cache(assets, count);
     
     for (int i = 0; i < count; i++) {
         SDL_free(assets[i].name);
         SDL_free(assets[i].ext);
         SDL_free(assets[i].path);
+        SDL_free(assets[i].block);
     }
     
-    printf("Florence Codegen complete.\n");
+    if (regenerate) {
+        printf("Florence Codegen complete.\n");
+    }
     SDL_Quit();
     return 0;
 }
@@ -1,6 +1,7 @@
 #include "entities.h"
 
 #include <Empire/assets.h>
+#include <Empire/audio_stream.h>
 #include <Empire/generated/assets_generated.h>
 #include <Empire/level.h>
 #include <Empire/math.inl>
@@ -26,13 +27,24 @@ void emp_damage_number(emp_vec2_t pos, u32 number);
 
 typedef struct emp_music_player
 {
-	ma_sound sounds[2];
-	ma_decoder decoders[2];
+	// Only the playing track and one still fading out hold a stream.
+	emp_audio_stream_t* streams[2];
+	emp_asset_t* tracks[2];
 	i32 track_steps[2];
-	i32 current_track;
+	u32 current_track;
 	bool initialized;
 } emp_music_player;
 
+static void music_start_track(emp_music_player* music, u32 track)
+{
+	emp_asset_t* asset = music->tracks[track];
+	music->streams[track] = emp_audio_stream_open(G->mixer, asset->path, asset->data.data, asset->data.size);
+	if (music->streams[track]) {
+		ma_sound_set_fade_in_milliseconds(&music->streams[track]->sound, 0, 1, 1000);
+		ma_sound_start(&music->streams[track]->sound);
+	}
+}
+
 void emp_music_player_init(void)
 {
 	G->music_player = (emp_music_player*)SDL_malloc(sizeof(*G->music_player));
@@ -52,32 +64,25 @@ void emp_music_player_init(void)
 	if (!G->mixer)
 		return;
 
-	typedef struct
-	{
-		ma_decoder decoder;
-		const void* data;
-		size_t size;
-	} emp_audio_t;
+	music->tracks[0] = &G->assets->ogg->calm_music_loopable;
+	music->tracks[1] = &G->assets->ogg->intense_music_loopable;
 
-	emp_asset_t* tracks[] = {
-		&G->assets->ogg->calm_music_loopable,
-		&G->assets->ogg->intense_music_loopable,
-	};
+	music->initialized = true;
+	music_start_track(music, 0);
+}
 
-	for (int i = 0; i < 2; i++) {
-		emp_audio_t* audio = tracks[i]->handle;
+void emp_music_player_destroy(void)
+{
+	emp_music_player* music = G->music_player;
+	if (!music)
+		return;
 
-		ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 2, G->mixer->sampleRate);
-		ma_result result = ma_decoder_init_memory(audio->data, audio->size, &config, &music->decoders[i]);
-		SDL_assert(result == MA_SUCCESS && "Failed to init music decoder");
-		result = ma_sound_init_from_data_source(G->mixer, &music->decoders[i], 0, NULL, &music->sounds[i]);
-		SDL_assert(result == MA_SUCCESS && "Failed to init music sound");
-		ma_sound_set_looping(&music->sounds[i], MA_TRUE);
+	for (u32 i = 0; i < SDL_arraysize(music->streams); i++) {
+		emp_audio_stream_close(music->streams[i]);
 	}
-
-	music->initialized = true;
-	ma_sound_set_fade_in_milliseconds(&music->sounds[0], 0, 1, 1000);
-	ma_sound_start(&music->sounds[0]);
+	emp_audio_stream_shutdown();
+	SDL_free(music);
+	G->music_player = NULL;
 }
 
 typedef struct emp_roamer_data_t
@@ -107,83 +112,294 @@ emp_player_conf_t get_player_conf()
 	return (emp_player_conf_t) { .speed = 60.0f };
 }
 
-#define SOUND_POOL_SIZE 32
+// At most EMP_MAX_VOICES effects are audible at once. A few spare voices
+// let a stolen voice sit out the rest of the frame after being stopped, so
+// its buffer is never repointed while the mixer may still be reading it.
+#define EMP_MAX_VOICES 32
+#define EMP_SPARE_VOICES 8
+#define EMP_MAX_SOUND_EVENTS 32
+// Each extra copy of an effect merged into one voice adds this much gain,
+// up to EMP_SOUND_MAX_GAIN.
+#define EMP_SOUND_MERGE_GAIN 0.25f
+#define EMP_SOUND_MAX_GAIN 2.0f
+
+typedef struct emp_sound_conf_t
+{
+	u32 priority;
+	u32 max_voices;
+} emp_sound_conf_t;
 
+// Every request for the same asset in a frame collapses into one event.
+typedef struct emp_sound_event_t
+{
+	emp_asset_t* asset;
+	emp_sound_conf_t conf;
+	u32 count;
+	float distance;
+} emp_sound_event_t;
+
+// A voice keeps its ma_sound for the life of the program; playing a new
+// effect only points its buffer at that effect's PCM and restarts it.
 typedef struct
 {
 	ma_sound sound;
-	ma_decoder decoder;
-	bool in_use;
-} emp_sound_slot_t;
+	ma_audio_buffer_ref buffer;
+	bool initialized;
+	emp_audio_t const* audio;
+	emp_asset_t* asset;
+	u32 priority;
+	float distance;
+	// A voice stopped while playing stays out of use until the engine clock
+	// has moved past `stopped_at`, when no mix can still be reading it.
+	bool draining;
+	ma_uint64 stopped_at;
+} emp_voice_t;
+
+static emp_voice_t g_voices[EMP_MAX_VOICES + EMP_SPARE_VOICES];
+static emp_sound_event_t g_sound_events[EMP_MAX_SOUND_EVENTS];
+static u32 g_sound_event_count;
+
+// Hits are frequent and expendable; feedback about the player is not.
+static emp_sound_conf_t sound_conf(emp_asset_t const* asset)
+{
+	if (asset == &G->assets->ogg->player_damage) {
+		return (emp_sound_conf_t) { .priority = 3, .max_voices = 2 };
+	}
+	if (asset == &G->assets->ogg->teleport) {
+		return (emp_sound_conf_t) { .priority = 3, .max_voices = 1 };
+	}
+	if (asset == &G->assets->ogg->obj_break) {
+		return (emp_sound_conf_t) { .priority = 2, .max_voices = 4 };
+	}
+	if (asset == &G->assets->ogg->enemy_damage || asset == &G->assets->ogg->obj_damage) {
+		return (emp_sound_conf_t) { .priority = 0, .max_voices = 4 };
+	}
+	return (emp_sound_conf_t) { .priority = 1, .max_voices = 4 };
+}
+
+void play_one_shot(emp_asset_t* asset, emp_vec2_t pos)
+{
+	if (!asset || !G->mixer)
+		return;
+
+	float distance = emp_vec2_dist(G->player->pos, pos);
+	for (u32 i = 0; i < g_sound_event_count; i++) {
+		emp_sound_event_t* event = &g_sound_events[i];
+		if (event->asset == asset) {
+			event->count++;
+			event->distance = SDL_min(event->distance, distance);
+			return;
+		}
+	}
+
+	if (g_sound_event_count == EMP_MAX_SOUND_EVENTS)
+		return;
+
+	g_sound_events[g_sound_event_count++] = (emp_sound_event_t) {
+		.asset = asset,
+		.conf = sound_conf(asset),
+		.count = 1,
+		.distance = distance,
+	};
+}
+
+static bool voice_is_playing(emp_voice_t const* voice)
+{
+	return voice->initialized && voice->audio && ma_sound_is_playing(&voice->sound);
+}
+
+static void voice_stop(emp_voice_t* voice)
+{
+	ma_sound_stop(&voice->sound);
+	voice->draining = true;
+	voice->stopped_at = ma_engine_get_time_in_pcm_frames(G->mixer);
+}
+
+static bool voice_is_drained(emp_voice_t* voice, ma_uint64 now)
+{
+	if (voice->draining && now > voice->stopped_at) {
+		voice->draining = false;
+	}
+	return !voice->draining;
+}
+
+// Orders voices and events by how much they matter: priority first, then
+// nearness to the player.
+static bool sound_outranks(u32 priority, float distance, u32 other_priority, float other_distance)
+{
+	return priority != other_priority ? priority > other_priority : distance < other_distance;
+}
+
+static int SDLCALL compare_sound_events(const void* a, const void* b)
+{
+	const emp_sound_event_t* ea = a;
+	const emp_sound_event_t* eb = b;
+	if (sound_outranks(ea->conf.priority, ea->distance, eb->conf.priority, eb->distance))
+		return -1;
+	if (sound_outranks(eb->conf.priority, eb->distance, ea->conf.priority, ea->distance))
+		return 1;
+	return 0;
+}
+
+static bool voice_start(emp_voice_t* voice, emp_audio_t const* audio)
+{
+	if (!voice->initialized) {
+		ma_result result = ma_audio_buffer_ref_init(ma_format_f32, EMP_AUDIO_CHANNELS, audio->pcm, audio->frame_count, &voice->buffer);
+		if (result != MA_SUCCESS)
+			return false;
+
+		result = ma_sound_init_from_data_source(G->mixer, &voice->buffer, 0, NULL, &voice->sound);
+		if (result != MA_SUCCESS) {
+			ma_audio_buffer_ref_uninit(&voice->buffer);
+			return false;
+		}
+		voice->initialized = true;
+	} else {
+		// The voice has stopped, so the mixer is no longer reading its
+		// buffer. This also rewinds it; ma_sound_start clears the end flag.
+		ma_audio_buffer_ref_set_data(&voice->buffer, audio->pcm, audio->frame_count);
+	}
 
-static emp_sound_slot_t g_sound_pool[SOUND_POOL_SIZE];
+	voice->audio = audio;
+	ma_sound_start(&voice->sound);
+	return true;
+}
 
-void play_one_shot(emp_asset_t* asset)
+static void play_sound_event(emp_sound_event_t const* event)
 {
-	if (!asset || !asset->handle || !G->mixer)
+	if (!emp_asset_is_loaded(event->asset))
+		return;
+	emp_audio_t const* audio = event->asset->handle;
+	if (!audio || !audio->pcm)
 		return;
 
-	typedef struct
-	{
-		ma_decoder decoder;
-		const void* data;
-		size_t size;
-	} emp_audio_t;
-	emp_audio_t* audio = asset->handle;
-
-	// Find a free slot (not playing)
-	emp_sound_slot_t* slot = NULL;
-	for (int i = 0; i < SOUND_POOL_SIZE; i++) {
-		if (!g_sound_pool[i].in_use) {
-			slot = &g_sound_pool[i];
-			break;
+	u32 playing = 0;
+	u32 playing_asset = 0;
+	emp_voice_t* idle = NULL;
+	emp_voice_t* victim = NULL;
+	ma_uint64 now = ma_engine_get_time_in_pcm_frames(G->mixer);
+	for (u32 i = 0; i < SDL_arraysize(g_voices); i++) {
+		emp_voice_t* voice = &g_voices[i];
+		if (!voice_is_playing(voice)) {
+			if (!idle && voice_is_drained(voice, now)) {
+				idle = voice;
+			}
+			continue;
 		}
-		// Check if a slot finished playing
-		if (!ma_sound_is_playing(&g_sound_pool[i].sound)) {
-			ma_sound_uninit(&g_sound_pool[i].sound);
-			ma_decoder_uninit(&g_sound_pool[i].decoder);
-			g_sound_pool[i].in_use = false;
-			slot = &g_sound_pool[i];
-			break;
+		playing++;
+		playing_asset += voice->asset == event->asset;
+		if (!victim || sound_outranks(victim->priority, victim->distance, voice->priority, voice->distance)) {
+			victim = voice;
 		}
 	}
 
-	if (!slot)
-		return; // All slots busy
+	if (playing_asset >= event->conf.max_voices || !idle)
+		return;
 
-	ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 2, G->mixer->sampleRate);
-	ma_result result = ma_decoder_init_memory(audio->data, audio->size, &config, &slot->decoder);
-	if (result != MA_SUCCESS)
+	if (playing >= EMP_MAX_VOICES) {
+		if (!sound_outranks(event->conf.priority, event->distance, victim->priority, victim->distance))
+			return;
+		voice_stop(victim);
+	}
+
+	if (!voice_start(idle, audio))
 		return;
 
-	result = ma_sound_init_from_data_source(G->mixer, &slot->decoder, 0, NULL, &slot->sound);
-	if (result != MA_SUCCESS) {
-		ma_decoder_uninit(&slot->decoder);
+	idle->asset = event->asset;
+	idle->priority = event->conf.priority;
+	idle->distance = event->distance;
+	float gain = 1.0f + EMP_SOUND_MERGE_GAIN * (float)(event->count - 1);
+	ma_sound_set_volume(&idle->sound, SDL_min(gain, EMP_SOUND_MAX_GAIN));
+}
+
+void emp_sound_flush(void)
+{
+	SDL_qsort(g_sound_events, g_sound_event_count, sizeof(g_sound_events[0]), compare_sound_events);
+	for (u32 i = 0; i < g_sound_event_count; i++) {
+		play_sound_event(&g_sound_events[i]);
+	}
+	g_sound_event_count = 0;
+}
+
+// Stopping a voice only flags it; a mix the audio thread is already running
+// may still read its buffer. Once the engine clock has moved on, that mix has
+// finished and the next one skips the stopped voice.
+static void wait_for_mixer(void)
+{
+	ma_uint64 stopped_at = ma_engine_get_time_in_pcm_frames(G->mixer);
+	u64 deadline = SDL_GetTicks() + 100;
+	while (ma_engine_get_time_in_pcm_frames(G->mixer) == stopped_at && SDL_GetTicks() < deadline) {
+		SDL_Delay(1);
+	}
+}
+
+// The caller frees the PCM next, so the voices are only detached from it
+// once the mixer can no longer be reading it.
+void emp_stop_voices(emp_audio_t const* audio)
+{
+	bool stopped = false;
+	for (u32 i = 0; i < SDL_arraysize(g_voices); i++) {
+		emp_voice_t* voice = &g_voices[i];
+		if (voice->initialized && voice->audio == audio) {
+			voice_stop(voice);
+			stopped = true;
+		}
+	}
+	if (!stopped) {
 		return;
 	}
 
-	slot->in_use = true;
-	ma_sound_start(&slot->sound);
+	wait_for_mixer();
+	for (u32 i = 0; i < SDL_arraysize(g_voices); i++) {
+		emp_voice_t* voice = &g_voices[i];
+		if (voice->initialized && voice->audio == audio && !ma_sound_is_playing(&voice->sound)) {
+			ma_audio_buffer_ref_set_data(&voice->buffer, NULL, 0);
+			voice->audio = NULL;
+		}
+	}
 }
 
-void play_one_shot_bullet(emp_weapon_conf_t* weapon)
+void play_one_shot_bullet(emp_weapon_conf_t* weapon, emp_vec2_t pos)
 {
 	double current_time = G->args->global_time;
 	if (current_time - weapon->last_played_ms < weapon->delay_between_shots) {
 		return;
 	}
 
-	play_one_shot(weapon->sound_asset);
+	play_one_shot(weapon->sound_asset, pos);
 
 	weapon->last_played_ms = G->args->global_time;
 }
 
 emp_vec2_t render_offset()
 {
-	int render_w, render_h;
-	SDL_Window* window = SDL_GetRenderWindow(G->renderer);
-	SDL_GetWindowSize(window, &render_w, &render_h);
-	return (emp_vec2_t) { .x = (float)render_w / 2.0f, .y = (float)render_h / 1.5f };
+	return (emp_vec2_t) { .x = G->view_size.x / 2.0f, .y = G->view_size.y / 1.5f };
+}
+
+emp_vec2_t world_to_screen(emp_vec2_t pos)
+{
+	emp_vec2_t offset = render_offset();
+	return (emp_vec2_t) {
+		.x = (pos.x - G->camera.x) * SPRITE_MAGNIFICATION + offset.x,
+		.y = (pos.y - G->camera.y) * SPRITE_MAGNIFICATION + offset.y,
+	};
+}
+
+// Set by emp_render for the frame being drawn.
+static float render_alpha = 1.0f;
+
+static emp_vec2_t interpolate(emp_vec2_t prev, emp_vec2_t pos)
+{
+	return (emp_vec2_t) {
+		.x = prev.x + (pos.x - prev.x) * render_alpha,
+		.y = prev.y + (pos.y - prev.y) * render_alpha,
+	};
+}
+
+static emp_vec2_t bullet_render_pos(u32 at)
+{
+	emp_bullets_t* bullets = G->bullets;
+	return interpolate((emp_vec2_t) { bullets->px[at], bullets->py[at] }, (emp_vec2_t) { bullets->x[at], bullets->y[at] });
 }
 
 void draw_rect_at(emp_vec2_t pos, float size, u8 r, u8 g, u8 b, u8 a)
@@ -197,8 +413,8 @@ void draw_rect_at(emp_vec2_t pos, float size, u8 r, u8 g, u8 b, u8 a)
 	rect.w = screen_size;
 	rect.h = screen_size;
 
-	rect.x -= G->player->pos.x * SPRITE_MAGNIFICATION;
-	rect.y -= G->player->pos.y * SPRITE_MAGNIFICATION;
+	rect.x -= G->camera.x * SPRITE_MAGNIFICATION;
+	rect.y -= G->camera.y * SPRITE_MAGNIFICATION;
 
 	emp_vec2_t offset = render_offset();
 	rect.x += offset.x;
@@ -238,8 +454,8 @@ SDL_FRect render_rect(emp_vec2_t pos, emp_texture_t* texture)
 	rect.w = width;
 	rect.h = height;
 
-	rect.x -= G->player->pos.x * SPRITE_MAGNIFICATION;
-	rect.y -= G->player->pos.y * SPRITE_MAGNIFICATION;
+	rect.x -= G->camera.x * SPRITE_MAGNIFICATION;
+	rect.y -= G->camera.y * SPRITE_MAGNIFICATION;
 
 	emp_vec2_t offset = render_offset();
 	rect.x += offset.x;
@@ -259,8 +475,8 @@ SDL_FRect render_rect_tile(emp_vec2_t pos, float grid_size)
 	rect.w = size;
 	rect.h = size;
 
-	rect.x -= G->player->pos.x * SPRITE_MAGNIFICATION;
-	rect.y -= G->player->pos.y * SPRITE_MAGNIFICATION;
+	rect.x -= G->camera.x * SPRITE_MAGNIFICATION;
+	rect.y -= G->camera.y * SPRITE_MAGNIFICATION;
 
 	emp_vec2_t offset = render_offset();
 	rect.x += offset.x;
@@ -290,56 +506,79 @@ bool tile_in_bounds(emp_vec2i_t tile)
 	return false;
 }
 
+static inline bool tile_bit(const u64* bits, u64 index)
+{
+	return (bits[index >> 6] >> (index & 63)) & 1;
+}
+
+static inline void tile_bit_set(u64* bits, u64 index)
+{
+	bits[index >> 6] |= (u64)1 << (index & 63);
+}
+
+static inline void tile_bit_clear(u64* bits, u64 index)
+{
+	bits[index >> 6] &= ~((u64)1 << (index & 63));
+}
+
+static u32 level_chunk_of_tile(u64 tile_index)
+{
+	u64 tx = tile_index % EMP_LEVEL_WIDTH;
+	u64 ty = tile_index / EMP_LEVEL_WIDTH;
+	return (u32)((ty / EMP_CHUNK_TILES) * EMP_LEVEL_CHUNKS_X + (tx / EMP_CHUNK_TILES));
+}
+
+static void level_chunk_mark_dirty(u32 chunk)
+{
+	G->level->chunk_dirty[chunk >> 6] |= (u64)1 << (chunk & 63);
+}
+
+static void level_health_mark_dirty(u32 chunk)
+{
+	G->level->health_dirty[chunk >> 6] |= (u64)1 << (chunk & 63);
+}
+
+bool tile_is_solid(u64 index)
+{
+	u64 word = index >> 6;
+	u64 bit = (u64)1 << (index & 63);
+	return ((G->level->walls[word] | G->level->breakable[word]) & bit) != 0;
+}
+
 bool check_overlap_map(emp_vec2_t pos)
 {
 	emp_vec2i_t tile = get_tile(pos);
 
 	if (tile_in_bounds(tile)) {
 		u64 index = tile.y * EMP_LEVEL_WIDTH + tile.x;
-		emp_tile_t* tile_data = G->level->tiles + index;
-		return tile_data->state != emp_tile_state_none;
+		return tile_is_solid(index);
 	}
 
 	return true;
 }
 
-bool check_overlap_bullet_enemy(emp_bullet_t* bullet, emp_enemy_t* enemy)
+float enemy_collision_radius(emp_enemy_t const* enemy)
 {
 	emp_texture_t* texture = enemy->texture_asset->handle;
-	float size = texture->width / 3.0f;
-	return emp_vec2_dist_sq(bullet->pos, enemy->pos) < size * size;
+	return texture->width / 3.0f;
 }
 
-bool check_overlap_bullet_player(emp_bullet_t* bullet, emp_player_t* player)
+bool check_overlap_bullet_enemy(emp_vec2_t bullet_pos, emp_enemy_t* enemy)
 {
-	emp_texture_t* texture = player->texture_asset->handle;
-	float size = texture->width / 3.0f;
-	return emp_vec2_dist_sq(bullet->pos, player->pos) < size * size;
+	float size = enemy_collision_radius(enemy);
+	return emp_vec2_dist_sq(bullet_pos, enemy->pos) < size * size;
 }
 
-bool check_overlap_bullet(emp_bullet_t* bullet, emp_vec2_t pos, float size)
+bool check_overlap_bullet_player(emp_vec2_t bullet_pos, emp_player_t* player)
 {
-	return emp_vec2_dist_sq(bullet->pos, pos) < size * size;
-}
-
-u64 index_from_tile(emp_vec2i_t tile)
-{
-	return tile.y * EMP_LEVEL_WIDTH + tile.x;
+	emp_texture_t* texture = player->texture_asset->handle;
+	float size = texture->width / 3.0f;
+	return emp_vec2_dist_sq(bullet_pos, player->pos) < size * size;
 }
 
-void add_enemy_to_tile(emp_enemy_t* enemy)
+bool check_overlap_bullet(emp_vec2_t bullet_pos, emp_vec2_t pos, float size)
 {
-	emp_vec2i_t tile = get_tile(enemy->pos);
-
-	if (tile_in_bounds(tile)) {
-		u64 index = index_from_tile(tile);
-		emp_enemy_t** first_enemy = &G->level->enemy_in_tile[index];
-		enemy->next_in_tile = *first_enemy;
-		*first_enemy = enemy;
-		G->level->enemy_in_tile[index] = enemy;
-	} else {
-		enemy->next_in_tile = NULL;
-	}
+	return emp_vec2_dist_sq(bullet_pos, pos) < size * size;
 }
 
 SDL_FRect source_rect(emp_texture_t* texture)
@@ -352,8 +591,8 @@ SDL_FRect source_rect(emp_texture_t* texture)
 
 	SDL_FRect rect;
 
-	rect.x = (float)(column * texture->source_size);
-	rect.y = (float)(row * texture->source_size);
+	rect.x = texture->x + (float)(column * texture->source_size);
+	rect.y = texture->y + (float)(row * texture->source_size);
 	rect.w = (float)texture->source_size;
 	rect.h = (float)texture->source_size;
 
@@ -366,6 +605,16 @@ u32 simple_rng(u32* state)
 	return (*state >> 16) & 0x7FFF;
 }
 
+void emp_seed_rng(u32 seed)
+{
+	rng_state = seed;
+}
+
+u32 emp_rng_state(void)
+{
+	return rng_state;
+}
+
 float random_float(float min, float max)
 {
 	float normalized = (float)simple_rng(&rng_state) / 32767.0f;
@@ -384,7 +633,8 @@ void enemy_chaser_update(emp_enemy_t* enemy)
 
 	float osc_amplitude = 12.5f;
 	float osc_frequency = 1.5f;
-	float phase_offset = (float)((uintptr_t)enemy % 1000) * 0.01f;
+	// Keyed on the slot rather than the address so replays match across runs.
+	float phase_offset = (float)((u64)(enemy - G->enemies) * sizeof(emp_enemy_t) % 1000) * 0.01f;
 	movement.y += SDL_sinf((float)G->args->global_time * osc_frequency + phase_offset) * osc_amplitude * dt;
 
 	emp_vec2_t new_pos = emp_vec2_add(enemy->pos, movement);
@@ -426,12 +676,12 @@ void enemy_roamer_update(emp_enemy_t* enemy)
 	}
 }
 
-void bullet_text_render(emp_bullet_t* bullet)
+void bullet_text_render(u32 at)
 {
-	SDL_FRect target = render_rect(bullet->pos, G->assets->png->bullet2_8.handle);
-	char buf[64];
-	SDL_snprintf(buf, 64, "%.0f", bullet->damage);
-	emp_draw_text(target.x, target.y, buf, 255, 255, 180, &G->assets->ttf->asepritefont);
+	emp_vec2_t pos = bullet_render_pos(at);
+	SDL_FRect target = render_rect(pos, G->assets->png->bullet2_8.handle);
+	u32 damage = (u32)SDL_max(G->bullets->damage[at] + 0.5f, 0.0f);
+	emp_draw_number(target.x, target.y, damage, 255, 255, 180, &G->assets->ttf->asepritefont, emp_layer_text);
 }
 
 #define ENEMY_CONF_CHEST 4
@@ -772,23 +1022,34 @@ void emp_init_weapon_configs()
 
 emp_bullet_h emp_create_bullet()
 {
-	for (u32 i = 1; i < EMP_MAX_BULLETS; ++i) {
-		emp_bullet_t* bullet = &G->bullets[i];
-		if (!bullet->alive) {
-			bullet->generation++;
-			bullet->pos = (emp_vec2_t){ 0 };
-			bullet->vel = (emp_vec2_t){ 0 };
-			bullet->life_left = 0.0f;
-			bullet->damage = 0.0f;
-			bullet->texture_asset = NULL;
-			bullet->alive = true;
-			return (emp_bullet_h) { .index = i, .generation = bullet->generation };
-		}
+	u32 i = emp_pool_alloc(&G->bullet_pool);
+	if (i == 0) {
+		assert(false && "out of bullets");
+		return (emp_bullet_h) { 0 };
 	}
 
-	assert(false && "out of bullets");
+	emp_bullets_t* bullets = G->bullets;
+	u32 at = emp_pool_dense_index(&G->bullet_pool, i);
+	bullets->x[at] = 0.0f;
+	bullets->y[at] = 0.0f;
+	bullets->px[at] = 0.0f;
+	bullets->py[at] = 0.0f;
+	bullets->vx[at] = 0.0f;
+	bullets->vy[at] = 0.0f;
+	bullets->life[at] = 0.0f;
+	bullets->damage[at] = 0.0f;
+	bullets->mask[at] = 0;
+	bullets->texture_asset[at] = NULL;
+	bullets->custom_render[at] = NULL;
+	return (emp_bullet_h) { .index = i, .generation = emp_pool_generation(&G->bullet_pool, i) };
+}
 
-	return (emp_bullet_h) { 0 };
+void emp_destroy_bullet(emp_bullet_h handle)
+{
+	if (emp_bullet_is_valid(handle)) {
+		u32 hole = emp_pool_free(&G->bullet_pool, handle.index);
+		emp_bullets_move(G->bullets, G->bullet_pool.count, hole);
+	}
 }
 
 
@@ -803,20 +1064,29 @@ void spawn_bullets(emp_vec2_t pos, emp_vec2_t direction, bullet_mask mask, emp_w
 	for (u32 i = 0; i < conf->num_shots; ++i) {
 		emp_bullet_conf_t bullet_conf = conf->shots[i];
 		emp_bullet_h bullet_handle = emp_create_bullet();
-		emp_bullet_t* bullet = &G->bullets[bullet_handle.index];
-		bullet->vel = emp_vec2_mul(emp_vec2_normalize(direction), bullet_conf.speed);
+		if (bullet_handle.index == 0) {
+			break;
+		}
+		emp_bullets_t* bullets = G->bullets;
+		u32 at = emp_pool_dense_index(&G->bullet_pool, bullet_handle.index);
+		emp_vec2_t vel = emp_vec2_mul(emp_vec2_normalize(direction), bullet_conf.speed);
 		if (bullet_conf.start_angle != 0.0f) {
-			bullet->vel = emp_vec2_rotate(bullet->vel, bullet_conf.start_angle);
+			vel = emp_vec2_rotate(vel, bullet_conf.start_angle);
 		}
-		bullet->life_left = bullet_conf.lifetime;
-		bullet->damage = bullet_conf.damage;
-		bullet->pos = pos;
-		bullet->texture_asset = bullet_conf.texture_asset;
-		bullet->mask = mask;
-		bullet->custom_render = bullet_conf.custom_render;
+		bullets->vx[at] = vel.x;
+		bullets->vy[at] = vel.y;
+		bullets->life[at] = bullet_conf.lifetime;
+		bullets->damage[at] = bullet_conf.damage;
+		bullets->x[at] = pos.x;
+		bullets->y[at] = pos.y;
+		bullets->px[at] = pos.x;
+		bullets->py[at] = pos.y;
+		bullets->texture_asset[at] = bullet_conf.texture_asset;
+		bullets->mask[at] = mask;
+		bullets->custom_render[at] = bullet_conf.custom_render;
 	}
 	if (conf->sound_asset) {
-		play_one_shot_bullet(conf);
+		play_one_shot_bullet(conf, pos);
 	}
 }
 
@@ -834,36 +1104,40 @@ u32 emp_create_player()
 
 emp_enemy_h emp_create_enemy(emp_vec2_t pos, u32 enemy_conf_index, float health, float movement_speed, u32 weapon_index, emp_spawner_h spawned_by)
 {
-	for (u32 i = 1; i < EMP_MAX_ENEMIES; ++i) {
-		emp_enemy_t* enemy = &G->enemies[i];
-		if (!enemy->alive) {
-			emp_enemy_conf_t* conf = enemy_confs[enemy_conf_index];
-			SDL_memset(&enemy->dynamic_data, 0, 64);
-			enemy->pos = pos;
-
-			emp_vec2_t player_pos = G->player->pos;
-			emp_vec2_t dir = emp_vec2_normalize(emp_vec2_sub(enemy->pos, player_pos));
-
-			float speed = movement_speed == 0.0f ? conf->speed : movement_speed;
-
-			enemy->direction = dir;
-			enemy->generation++;
-			enemy->health = health == 0.0f ? conf->health : health;
-			enemy->update = conf->update;
-			enemy->late_update = conf->late_update;
-			enemy->speed = random_float(speed * 0.8f, speed * 1.2f);
-			enemy->texture_asset = conf->texture_asset;
-			enemy->weapon = weapons[weapon_index];
-			enemy->alive = true;
-			enemy->spawned_by = spawned_by;
-			enemy->enemy_shot_delay = 4.0;
-			return (emp_enemy_h) { .index = i, .generation = enemy->generation };
-		}
+	u32 i = emp_pool_alloc(&G->enemy_pool);
+	if (i == 0) {
+		assert(false && "out of enemies");
+		return (emp_enemy_h) { 0 };
 	}
 
-	assert(false && "out of enemies");
+	emp_enemy_t* enemy = &G->enemies[i];
+	emp_enemy_conf_t* conf = enemy_confs[enemy_conf_index];
+	SDL_memset(&enemy->dynamic_data, 0, 64);
+	enemy->pos = pos;
+	enemy->prev_pos = pos;
 
-	return (emp_enemy_h) { 0 };
+	emp_vec2_t player_pos = G->player->pos;
+	emp_vec2_t dir = emp_vec2_normalize(emp_vec2_sub(enemy->pos, player_pos));
+
+	float speed = movement_speed == 0.0f ? conf->speed : movement_speed;
+
+	enemy->direction = dir;
+	enemy->health = health == 0.0f ? conf->health : health;
+	enemy->update = conf->update;
+	enemy->late_update = conf->late_update;
+	enemy->speed = random_float(speed * 0.8f, speed * 1.2f);
+	enemy->texture_asset = conf->texture_asset;
+	enemy->weapon = weapons[weapon_index];
+	enemy->spawned_by = spawned_by;
+	enemy->enemy_shot_delay = 4.0;
+	return (emp_enemy_h) { .index = i, .generation = emp_pool_generation(&G->enemy_pool, i) };
+}
+
+void emp_destroy_enemy(emp_enemy_h handle)
+{
+	if (emp_enemy_is_valid(handle)) {
+		emp_pool_free(&G->enemy_pool, handle.index);
+	}
 }
 
 void emp_create_chest(emp_vec2_t pos, u32 weapon_index)
@@ -874,47 +1148,72 @@ void emp_create_chest(emp_vec2_t pos, u32 weapon_index)
 	(void)handle;
 }
 
-void emp_create_spawner(emp_vec2_t pos, float health, float enemy_health, float movement_speed, u32 enemy_conf_index, u32 weapon_index, float frequency, u32 limit)
-{
-	for (u32 i = 1; i < EMP_MAX_SPAWNERS; ++i) {
-		emp_spawner_t* spawner = &G->spawners[i];
-		if (!spawner->alive) {
-			SDL_memset(spawner, 0, sizeof(*spawner));
-			spawner->enemy_conf_index = enemy_conf_index;
-			spawner->alive = true;
-			spawner->frequency = frequency;
-			spawner->accumulator = 0;
-			spawner->health = health;
-			spawner->enemy_health = enemy_health;
-			spawner->weapon_index = weapon_index;
-			spawner->movement_speed = movement_speed;
-			spawner->x = pos.x;
-			spawner->y = pos.y;
-			spawner->limit = limit;
-			return;
-		}
+emp_spawner_h emp_create_spawner(emp_vec2_t pos, float health, float enemy_health, float movement_speed, u32 enemy_conf_index, u32 weapon_index, float frequency, u32 limit)
+{
+	u32 i = emp_pool_alloc(&G->spawner_pool);
+	if (i == 0) {
+		assert(false && "out of spawners");
+		return (emp_spawner_h) { 0 };
 	}
-	assert(false && "out of enemies");
+
+	emp_spawner_t* spawner = &G->spawners[i];
+	SDL_memset(spawner, 0, sizeof(*spawner));
+	spawner->enemy_conf_index = enemy_conf_index;
+	spawner->frequency = frequency;
+	spawner->accumulator = 0;
+	spawner->health = health;
+	spawner->enemy_health = enemy_health;
+	spawner->weapon_index = weapon_index;
+	spawner->movement_speed = movement_speed;
+	spawner->x = pos.x;
+	spawner->y = pos.y;
+	spawner->limit = limit;
+	return (emp_spawner_h) { .index = i, .generation = emp_pool_generation(&G->spawner_pool, i) };
 }
 
-emp_bullet_generator_h emp_create_bullet_generator()
+void emp_destroy_spawner(emp_spawner_h handle)
 {
-	for (u32 i = 0; i < EMP_MAX_BULLET_GENERATORS; ++i) {
-		emp_bullet_generator_t* gen = &G->generators[i];
-		if (!gen->alive) {
-			gen->generation++;
-			gen->alive = true;
-			return (emp_bullet_generator_h) { .index = i, .generation = gen->generation };
-		}
+	if (emp_spawner_is_valid(handle)) {
+		emp_pool_free(&G->spawner_pool, handle.index);
 	}
+}
 
-	assert(false && "out of generators");
+emp_bullet_generator_h emp_create_bullet_generator()
+{
+	u32 i = emp_pool_alloc(&G->generator_pool);
+	if (i == 0) {
+		assert(false && "out of generators");
+		return (emp_bullet_generator_h) { 0 };
+	}
 
-	return (emp_bullet_generator_h) { 0 };
+	return (emp_bullet_generator_h) { .index = i, .generation = emp_pool_generation(&G->generator_pool, i) };
 }
 
 void emp_destroy_bullet_generator(emp_bullet_generator_h handle)
 {
+	if (emp_bullet_generator_is_valid(handle)) {
+		emp_pool_free(&G->generator_pool, handle.index);
+	}
+}
+
+bool emp_enemy_is_valid(emp_enemy_h handle)
+{
+	return emp_pool_is_valid(&G->enemy_pool, handle.index, handle.generation);
+}
+
+bool emp_bullet_is_valid(emp_bullet_h handle)
+{
+	return emp_pool_is_valid(&G->bullet_pool, handle.index, handle.generation);
+}
+
+bool emp_spawner_is_valid(emp_spawner_h handle)
+{
+	return emp_pool_is_valid(&G->spawner_pool, handle.index, handle.generation);
+}
+
+bool emp_bullet_generator_is_valid(emp_bullet_generator_h handle)
+{
+	return emp_pool_is_valid(&G->generator_pool, handle.index, handle.generation);
 }
 
 void emp_music_player_update(emp_music_player* music)
@@ -922,30 +1221,42 @@ void emp_music_player_update(emp_music_player* music)
 	if (!music->initialized)
 		return;
 
-	i32 preferred_track = 0;
-	for (i32 index = 0; index < SDL_arraysize(music->track_steps); index++) {
+	u32 preferred_track = 0;
+	for (u32 index = 0; index < SDL_arraysize(music->track_steps); index++) {
 		if (G->player->pos.x < music->track_steps[index]) {
 			preferred_track = index;
 			break;
 		}
 	}
-	preferred_track = SDL_min(preferred_track, SDL_arraysize(music->track_steps));
+	preferred_track = SDL_min(preferred_track, (u32)SDL_arraysize(music->track_steps) - 1);
 	if (preferred_track != music->current_track) {
-		// Fade out current track
-		ma_sound_set_fade_in_milliseconds(&music->sounds[music->current_track], -1, 0, 1000);
-		ma_sound_set_stop_time_in_milliseconds(&music->sounds[music->current_track], 1000);
+		// Fade out current track; the stop is scheduled a second past the
+		// engine's current time.
+		emp_audio_stream_t* current = music->streams[music->current_track];
+		if (current) {
+			ma_sound_stop_with_fade_in_milliseconds(&current->sound, 1000);
+		}
 
-		// Start and fade in new track
+		// Start and fade in new track, from the top like before
 		music->current_track = preferred_track;
-		ma_sound_seek_to_pcm_frame(&music->sounds[music->current_track], 0);
-		ma_sound_set_fade_in_milliseconds(&music->sounds[music->current_track], 0, 1, 1000);
-		ma_sound_start(&music->sounds[music->current_track]);
+		emp_audio_stream_close(music->streams[music->current_track]);
+		music_start_track(music, music->current_track);
 	}
+
+	// A faded out track gives its decoder back once it has stopped.
+	for (u32 i = 0; i < SDL_arraysize(music->streams); i++) {
+		emp_audio_stream_t* stream = music->streams[i];
+		if (i != music->current_track && stream && !ma_sound_is_playing(&stream->sound)) {
+			emp_audio_stream_close(stream);
+			music->streams[i] = NULL;
+		}
+	}
+	emp_audio_stream_update();
 }
 
 void emp_player_update(emp_player_t* player)
 {
-	const bool* state = SDL_GetKeyboardState(NULL);
+	const emp_input_t* input = &G->input;
 	emp_player_conf_t conf = get_player_conf();
 
 	if (player->alive && player->health <= 0 && player->died_at_time == 0) {
@@ -953,115 +1264,105 @@ void emp_player_update(emp_player_t* player)
 		player->alive = false;
 	}
 
-	emp_texture_t* tex = player->texture_asset->handle;
-	SDL_FRect src = source_rect(tex);
-	SDL_FRect dst = player_rect(player->pos, tex);
-
-	if (player->alive) {
-		dst.x = player->flip ? dst.x + dst.w : dst.x;
-		dst.w = player->flip ? -dst.w : dst.w;
-		double t = 0.3;
-		double has_taken_damage = player->last_damage_time + t - G->args->global_time;
-		if (has_taken_damage > 0.0) {
-			u8 mod_value = 255 - (u8)(600.0 * has_taken_damage);
-			SDL_SetTextureColorMod(tex->texture, 255, mod_value, mod_value);
-			SDL_RenderTexture(G->renderer, tex->texture, &src, &dst);
-			SDL_SetTextureColorMod(tex->texture, 255, 255, 255);
-		} else {
-			SDL_SetTextureColorMod(tex->texture, 255, 255, 255);
-			SDL_RenderTexture(G->renderer, tex->texture, &src, &dst);
-		}
-	} else {
-		dst.y = dst.y + dst.h;
-		dst.h = -dst.w;
-		SDL_SetTextureColorMod(tex->texture, 47, 77, 47);
-		SDL_RenderTexture(G->renderer, tex->texture, &src, &dst);
-
+	if (!player->alive) {
 		double time_left = player->died_at_time + 3 - G->args->global_time;
-		char buf[64];
-		SDL_snprintf(buf, 64, "You died.. Respawn in %d", (int)time_left);
-		emp_draw_text(dst.x - 230, dst.y, buf, 223, 132, 165, &G->assets->ttf->asepritefont);
 		if (time_left <= 0) {
 			emp_create_level(&G->assets->ldtk->world, 1);
 		}
+		return;
 	}
 
-	if (player->alive) {
-		emp_vec2_t movement = { 0 };
+	emp_vec2_t movement = { 0 };
 
-		if (state[SDL_SCANCODE_W]) {
-			movement.y = -conf.speed;
-		}
+	if (emp_input_down(input, emp_key_up)) {
+		movement.y = -conf.speed;
+	}
 
-		if (state[SDL_SCANCODE_A]) {
-			movement.x = -conf.speed;
-			player->flip = true;
-		}
+	if (emp_input_down(input, emp_key_left)) {
+		movement.x = -conf.speed;
+		player->flip = true;
+	}
 
-		if (state[SDL_SCANCODE_S]) {
-			movement.y = conf.speed;
-		}
+	if (emp_input_down(input, emp_key_down)) {
+		movement.y = conf.speed;
+	}
 
-		if (state[SDL_SCANCODE_D]) {
-			movement.x = conf.speed;
-			player->flip = false;
-		}
+	if (emp_input_down(input, emp_key_right)) {
+		movement.x = conf.speed;
+		player->flip = false;
+	}
 
-		if (state[SDL_SCANCODE_M]) {
-			player->health = 0.0f;
-		}
+	if (emp_input_down(input, emp_key_kill)) {
+		player->health = 0.0f;
+	}
 
-		movement = emp_vec2_normalize(movement);
-		float speed = player->movement_speed == 0.0f ? conf.speed : player->movement_speed;
-		movement = emp_vec2_mul(movement, G->args->dt * speed);
+	movement = emp_vec2_normalize(movement);
+	float speed = player->movement_speed == 0.0f ? conf.speed : player->movement_speed;
+	movement = emp_vec2_mul(movement, G->args->dt * speed);
 
-		emp_vec2_t mouse_pos;
-		SDL_MouseButtonFlags buttons = SDL_GetMouseState(&mouse_pos.x, &mouse_pos.y);
+	emp_vec2_t pos_dx = emp_vec2_addx(player->pos, movement);
+	if (check_overlap_map(pos_dx)) {
+		movement.x = 0;
+	}
 
-		emp_vec2_t pos_dx = emp_vec2_addx(player->pos, movement);
-		if (check_overlap_map(pos_dx)) {
-			movement.x = 0;
-		}
+	emp_vec2_t pos_dy = emp_vec2_addy(player->pos, movement);
+	if (check_overlap_map(pos_dy)) {
+		movement.y = 0;
+	}
+
+	player->pos = emp_vec2_add(player->pos, movement);
 
-		emp_vec2_t pos_dy = emp_vec2_addy(player->pos, movement);
-		if (check_overlap_map(pos_dy)) {
-			movement.y = 0;
+	bool weapon_selected = false;
+	for (u32 w = emp_key_weapon_1; w <= emp_key_weapon_8 && !weapon_selected; ++w) {
+		if (emp_input_down(input, (emp_input_key)w)) {
+			player->weapon_index = w - emp_key_weapon_1 + 1;
+			weapon_selected = true;
 		}
+	}
+	if (!weapon_selected && emp_input_down(input, emp_key_reload_level)) {
+		emp_create_level(&G->assets->ldtk->world, 1);
+	}
 
-		player->pos = emp_vec2_add(player->pos, movement);
-
-		if (state[SDL_SCANCODE_1]) {
-			player->weapon_index = 1;
-		} else if (state[SDL_SCANCODE_2]) {
-			player->weapon_index = 2;
-		} else if (state[SDL_SCANCODE_3]) {
-			player->weapon_index = 3;
-		} else if (state[SDL_SCANCODE_4]) {
-			player->weapon_index = 4;
-		} else if (state[SDL_SCANCODE_5]) {
-			player->weapon_index = 5;
-		} else if (state[SDL_SCANCODE_6]) {
-			player->weapon_index = 6;
-		} else if (state[SDL_SCANCODE_7]) {
-			player->weapon_index = 7;
-		} else if (state[SDL_SCANCODE_8]) {
-			player->weapon_index = 8;
-		} else if (state[SDL_SCANCODE_K]) {
-			emp_create_level(&G->assets->ldtk->world, 1);
+	if (input->buttons & SDL_BUTTON_MASK(SDL_BUTTON_LEFT) || emp_input_down(input, emp_key_fire)) {
+		if (player->last_shot + weapons[player->weapon_index]->delay_between_shots < G->args->global_time) {
+			// The camera follows the player, so its screen position is the view offset.
+			emp_vec2_t delta = emp_vec2_sub(input->mouse, render_offset());
+			spawn_bullets(player->pos, delta, emp_enemy_bullet_mask | emp_heavy_bullet_mask, weapons[player->weapon_index]);
+			player->last_shot = G->args->global_time;
 		}
+	}
+}
 
-		if (buttons & SDL_BUTTON_MASK(SDL_BUTTON_LEFT) || state[SDL_SCANCODE_SPACE]) {
-			if (player->last_shot + weapons[player->weapon_index]->delay_between_shots < G->args->global_time) {
-				emp_vec2_t player_screen_pos = (emp_vec2_t) { .x = dst.x + dst.w / 2, .y = dst.y + dst.h / 2 };
-				emp_vec2_t delta = emp_vec2_sub(mouse_pos, player_screen_pos);
-				spawn_bullets(player->pos, delta, emp_enemy_bullet_mask | emp_heavy_bullet_mask, weapons[player->weapon_index]);
-				player->last_shot = G->args->global_time;
-			}
+void emp_player_render(emp_player_t const* player)
+{
+	emp_texture_t* tex = player->texture_asset->handle;
+	SDL_FRect src = source_rect(tex);
+	SDL_FRect dst = player_rect(player->pos, tex);
+
+	if (player->alive) {
+		dst.x = player->flip ? dst.x + dst.w : dst.x;
+		dst.w = player->flip ? -dst.w : dst.w;
+		double t = 0.3;
+		double has_taken_damage = player->last_damage_time + t - G->args->global_time;
+		SDL_FColor color = EMP_SPRITE_WHITE;
+		if (has_taken_damage > 0.0) {
+			u8 mod_value = 255 - (u8)(600.0 * has_taken_damage);
+			color = emp_sprite_color(255, mod_value, mod_value, 255);
 		}
+		emp_sprite_batch_draw(G->sprites, emp_layer_player, tex->texture, &src, &dst, color);
+	} else {
+		dst.y = dst.y + dst.h;
+		dst.h = -dst.w;
+		emp_sprite_batch_draw(G->sprites, emp_layer_player, tex->texture, &src, &dst, emp_sprite_color(47, 77, 47, 255));
+
+		double time_left = player->died_at_time + 3 - G->args->global_time;
+		char buf[64];
+		SDL_snprintf(buf, 64, "You died.. Respawn in %d", (int)time_left);
+		emp_draw_text(dst.x - 230, dst.y, buf, 223, 132, 165, &G->assets->ttf->asepritefont, emp_layer_text);
 	}
 }
 
-void emp_enemy_update(emp_enemy_t* enemy)
+void emp_enemy_update(u32 index, emp_enemy_t* enemy)
 {
 	float dist = emp_vec2_dist(G->player->pos, enemy->pos);
 	if (dist > 450.0f) {
@@ -1072,7 +1373,7 @@ void emp_enemy_update(emp_enemy_t* enemy)
 		enemy->update(enemy);
 	}
 
-	add_enemy_to_tile(enemy);
+	emp_spatial_hash_insert(&G->enemy_grid, enemy->pos, enemy_collision_radius(enemy), index);
 
 	emp_vec2_t player_pos = G->player->pos;
 	emp_vec2_t dir = emp_vec2_normalize(emp_vec2_sub(player_pos, enemy->pos));
@@ -1081,36 +1382,41 @@ void emp_enemy_update(emp_enemy_t* enemy)
 		spawn_bullets(enemy->pos, dir, emp_player_bullet_mask, enemy->weapon);
 		enemy->last_shot = G->args->global_time;
 	}
+}
+
+void emp_enemy_render(emp_enemy_t const* enemy)
+{
+	float dist = emp_vec2_dist(G->player->pos, enemy->pos);
+	if (dist > 450.0f) {
+		return;
+	}
 
 	emp_texture_t* texture = enemy->texture_asset->handle;
 
 	SDL_FRect src = source_rect(texture);
-	SDL_FRect dst = render_rect(enemy->pos, texture);
+	SDL_FRect dst = render_rect(interpolate(enemy->prev_pos, enemy->pos), texture);
 	dst.x = enemy->flip ? dst.x + dst.w : dst.x;
 	dst.w = enemy->flip ? -dst.w : dst.w;
 
 	double t = 0.3;
 	double has_taken_damage = enemy->last_damage_time + t - G->args->global_time;
+	SDL_FColor color = EMP_SPRITE_WHITE;
 	if (has_taken_damage > 0.0) {
 		u8 mod_value = 255 - (u8)(600.0 * has_taken_damage);
-		SDL_SetTextureColorMod(texture->texture, 255, mod_value, mod_value);
-		SDL_RenderTexture(G->renderer, texture->texture, &src, &dst);
-		SDL_SetTextureColorMod(texture->texture, 255, 255, 255);
-	} else {
-		SDL_RenderTexture(G->renderer, texture->texture, &src, &dst);
+		color = emp_sprite_color(255, mod_value, mod_value, 255);
 	}
+	emp_sprite_batch_draw(G->sprites, emp_layer_enemy, texture->texture, &src, &dst, color);
 }
 
-void emp_enemy_late_update(emp_enemy_t* enemy)
+void emp_enemy_late_update(u32 index, emp_enemy_t* enemy)
 {
 	if (enemy->late_update) {
 		enemy->late_update(enemy);
 	}
 
 	if (enemy->health <= 0) {
-		u32 spawned_by = enemy->spawned_by.index;
-		enemy->alive = false;
-		if (spawned_by && spawned_by < EMP_MAX_SPAWNERS) {
+		emp_pool_free(&G->enemy_pool, index);
+		if (emp_spawner_is_valid(enemy->spawned_by)) {
 			emp_spawner_t* spawner = G->spawners + enemy->spawned_by.index;
 			SDL_assert(spawner->count != 0);
 			spawner->count = spawner->count - 1;
@@ -1118,100 +1424,111 @@ void emp_enemy_late_update(emp_enemy_t* enemy)
 	}
 }
 
-void emp_bullet_update(emp_bullet_t* bullet)
+// Runs after emp_bullets_integrate has moved the bullet at dense position `at`.
+void emp_bullet_update(u32 at)
 {
-	bullet->life_left -= G->args->dt;
-
-	bullet->pos.x += bullet->vel.x * G->args->dt;
-	bullet->pos.y += bullet->vel.y * G->args->dt;
-
-	if (bullet->life_left <= 0.0f) {
-		bullet->alive = false;
+	emp_bullets_t* bullets = G->bullets;
+	bool alive = true;
+	emp_vec2_t bullet_pos = { bullets->x[at], bullets->y[at] };
+	bullet_mask mask = bullets->mask[at];
+	float damage = bullets->damage[at];
+
+	if (bullets->life[at] <= 0.0f) {
+		alive = false;
 	}
 
-	emp_vec2i_t tile = get_tile(bullet->pos);
+	emp_vec2i_t tile = get_tile(bullet_pos);
 
-	if (tile_in_bounds(tile) && (bullet->mask & emp_particle_bullet_mask) == 0) {
+	if (tile_in_bounds(tile) && (mask & emp_particle_bullet_mask) == 0) {
 		u32 index = ((u32)tile.y * EMP_LEVEL_WIDTH) + (u32)tile.x;
-		emp_tile_t* tile_data = &G->level->tiles[index];
 
-		if (tile_data->state != emp_tile_state_none) {
-			bullet->alive = false;
-			if (tile_data->state == emp_tile_state_breakable) {
-				if (bullet->mask & emp_heavy_bullet_mask && G->level->health[index].value > 0) {
+		if (tile_is_solid(index)) {
+			alive = false;
+			if (tile_bit(G->level->breakable, index)) {
+				if (mask & emp_heavy_bullet_mask && G->level->health[index].value > 0) {
 					G->level->health[index].value--;
+					level_health_mark_dirty(level_chunk_of_tile(index));
 					if (G->level->health[index].value == 0) {
-						play_one_shot(&G->assets->ogg->obj_break);
+						tile_bit_clear(G->level->breakable, index);
+						level_chunk_mark_dirty(level_chunk_of_tile(index));
+						play_one_shot(&G->assets->ogg->obj_break, bullet_pos);
 					} else {
-						play_one_shot(&G->assets->ogg->obj_damage);
+						play_one_shot(&G->assets->ogg->obj_damage, bullet_pos);
 					}
 				}
 			}
 		}
 	}
 
-	if (bullet->custom_render) {
-		bullet->custom_render(bullet);
-	}
-
-	if ((bullet->mask & emp_particle_bullet_mask) == 0) {
-		emp_texture_t* tex = bullet->texture_asset->handle;
-		SDL_FRect dstRect = render_rect(bullet->pos, bullet->texture_asset->handle);
-		SDL_RenderTexture(G->renderer, tex->texture, NULL, &dstRect);
-		draw_rect_at(bullet->pos, 32, 255, 0, 0, 255);
-
-		if (bullet->mask & emp_enemy_bullet_mask) {
-			for (int y = -1; y <= 1; ++y) {
-				for (int x = -1; x <= 1; ++x) {
-					emp_vec2i_t bullet_tile = get_tile(bullet->pos);
-					if (tile_in_bounds(bullet_tile)) {
-						bullet_tile.x += x;
-						bullet_tile.y += y;
-						emp_enemy_t* enemy_in_tile = G->level->enemy_in_tile[index_from_tile(bullet_tile)];
-						while (enemy_in_tile != NULL) {
-							if (check_overlap_bullet_enemy(bullet, enemy_in_tile)) {
-								bullet->alive = false;
-								enemy_in_tile->health -= bullet->damage;
-								enemy_in_tile->last_damage_time = G->args->global_time;
-								play_one_shot(&G->assets->ogg->enemy_damage);
-								emp_damage_number(enemy_in_tile->pos, (u32)bullet->damage);
-								goto collision_done;
-							}
-							enemy_in_tile = enemy_in_tile->next_in_tile;
-						}
-					}
+	if ((mask & emp_particle_bullet_mask) == 0) {
+		if (mask & emp_enemy_bullet_mask) {
+			u32 nearby[64];
+			u32 nearby_count = emp_spatial_hash_query(&G->enemy_grid, bullet_pos, nearby, SDL_arraysize(nearby));
+			for (u32 i = 0; i < nearby_count; ++i) {
+				emp_enemy_t* enemy = &G->enemies[nearby[i]];
+				if (check_overlap_bullet_enemy(bullet_pos, enemy)) {
+					alive = false;
+					enemy->health -= damage;
+					enemy->last_damage_time = G->args->global_time;
+					play_one_shot(&G->assets->ogg->enemy_damage, bullet_pos);
+					emp_damage_number(enemy->pos, (u32)damage);
+					goto collision_done;
 				}
 			}
 
-			for (u32 i = 0; i < EMP_MAX_SPAWNERS; ++i) {
-				emp_spawner_t* spawner = &G->spawners[i];
-				if (spawner->alive) {
-					emp_vec2_t pos = (emp_vec2_t) { .x = spawner->x, .y = spawner->y };
-					SDL_FRect dst = render_rect(pos, G->assets->png->cave2_32.handle);
-					emp_vec2_t centre = (emp_vec2_t) { .x = pos.x + (dst.w / 2), .y = pos.y + (dst.h / 2) };
-					if (check_overlap_bullet(bullet, centre, dst.w)) {
-						spawner->health = spawner->health - bullet->damage;
-						bullet->alive = false;
-						play_one_shot(&G->assets->ogg->enemy_damage);
-						if (spawner->health == 0) {
-							spawner->alive = false;
-						}
+			for (u32 i = G->spawner_pool.count; i-- > 0;) {
+				u32 spawner_index = G->spawner_pool.dense[i];
+				emp_spawner_t* spawner = &G->spawners[spawner_index];
+				emp_vec2_t pos = (emp_vec2_t) { .x = spawner->x, .y = spawner->y };
+				emp_texture_t* texture = G->assets->png->cave2_32.handle;
+				float w = texture->width * SPRITE_MAGNIFICATION;
+				float h = texture->height * SPRITE_MAGNIFICATION;
+				emp_vec2_t centre = (emp_vec2_t) { .x = pos.x + (w / 2), .y = pos.y + (h / 2) };
+				if (check_overlap_bullet(bullet_pos, centre, w)) {
+					spawner->health = spawner->health - damage;
+					alive = false;
+					play_one_shot(&G->assets->ogg->enemy_damage, bullet_pos);
+					if (spawner->health == 0) {
+						emp_pool_free(&G->spawner_pool, spawner_index);
 					}
 				}
 			}
 		}
 
 	collision_done:;
-		if (bullet->mask & emp_player_bullet_mask) {
-			if (check_overlap_bullet_player(bullet, G->player)) {
-				// emp_damage_number(G->player->pos, (u32)bullet->damage);
-				play_one_shot(&G->assets->ogg->player_damage);
-				G->player->health = G->player->health -= bullet->damage;
+		if (mask & emp_player_bullet_mask) {
+			if (check_overlap_bullet_player(bullet_pos, G->player)) {
+				// emp_damage_number(G->player->pos, (u32)damage);
+				play_one_shot(&G->assets->ogg->player_damage, G->player->pos);
+				G->player->health = G->player->health -= damage;
 				G->player->last_damage_time = G->args->global_time;
-				bullet->alive = false;
+				alive = false;
 			}
 		}
 	}
+
+	if (!alive) {
+		u32 hole = emp_pool_free(&G->bullet_pool, G->bullet_pool.dense[at]);
+		emp_bullets_move(bullets, G->bullet_pool.count, hole);
+	}
+}
+
+void emp_bullet_render(u32 at)
+{
+	emp_bullets_t* bullets = G->bullets;
+
+	if (bullets->custom_render[at]) {
+		bullets->custom_render[at](at);
+	}
+
+	if ((bullets->mask[at] & emp_particle_bullet_mask) == 0) {
+		emp_vec2_t bullet_pos = bullet_render_pos(at);
+		emp_texture_t* tex = bullets->texture_asset[at]->handle;
+		SDL_FRect dstRect = render_rect(bullet_pos, tex);
+		SDL_FRect src = { tex->x, tex->y, tex->width * (float)tex->columns, tex->height * (float)tex->rows };
+		emp_sprite_batch_draw(G->sprites, emp_layer_bullet, tex->texture, &src, &dstRect, EMP_SPRITE_WHITE);
+		draw_rect_at(bullet_pos, 32, 255, 0, 0, 255);
+	}
 }
 
 static emp_texture_t* emp_texture_find(const char* path)
@@ -1225,73 +1542,283 @@ static emp_texture_t* emp_texture_find(const char* path)
 	return NULL;
 }
 
-void emp_level_update(void)
+static emp_sprite_batch_t g_bake_batch;
+
+static bool level_tile_index(emp_vec2_t pos, float grid_size, u64* out_index)
 {
-	emp_level_asset_t* level_asset = (emp_level_asset_t*)G->assets->ldtk->world.handle;
+	float fx = SDL_floorf(pos.x / grid_size);
+	float fy = SDL_floorf(pos.y / grid_size);
+	if (fx < 0.0f || fy < 0.0f || fx >= (float)EMP_LEVEL_WIDTH || fy >= (float)EMP_LEVEL_HEIGHT) {
+		return false;
+	}
+	*out_index = ((u64)fy * EMP_LEVEL_WIDTH) + (u64)fx;
+	return true;
+}
 
-	memset(G->level->tiles, 0, sizeof(*G->level->tiles) * EMP_LEVEL_TILES);
+// Collision and the chunk cache index the world in EMP_TILE_SIZE tiles, so
+// sublevels on any other grid are left out of both.
+static bool sublevel_on_tile_grid(const emp_sublevel_t* sublevel)
+{
+	return sublevel->values.grid_size == EMP_TILE_SIZE;
+}
 
-	for (u64 li = 0; li < level_asset->sublevels.count; li++) {
-		emp_sublevel_t* sublevel = level_asset->sublevels.entries + li;
+static void level_chunks_release_textures(void)
+{
+	emp_level_chunks_t* chunks = G->chunks;
+	for (u32 c = 0; c < EMP_LEVEL_CHUNKS; ++c) {
+		if (chunks->textures[c]) {
+			SDL_DestroyTexture(chunks->textures[c]);
+			chunks->textures[c] = NULL;
+		}
+	}
+}
 
-		emp_texture_t* texture = emp_texture_find(sublevel->tiles.tilemap);
-		emp_texture_t* deco = emp_texture_find(sublevel->decoration.tiles.tilemap);
-		if (texture != NULL) {
-			for (u64 ti = 0; ti < sublevel->tiles.count; ti++) {
-				float grid_size = sublevel->values.grid_size;
-				emp_tile_desc_t* desc = sublevel->tiles.values + ti;
-				u64 lx = (u64)(desc->dst.x / grid_size);
-				u64 ly = (u64)(desc->dst.y / grid_size);
-
-				size_t index = (size_t)(ly * sublevel->values.grid_width) + (size_t)lx;
-				u8 value = sublevel->values.entries[index];
-
-				SDL_FRect src = { desc->src.x, desc->src.y, grid_size, grid_size };
-				emp_vec2_t pos = emp_vec2_add(desc->dst, sublevel->offset);
-				u64 wx = (u64)(pos.x / grid_size);
-				u64 wy = (u64)(pos.y / grid_size);
-
-				u64 di = (wy * EMP_LEVEL_WIDTH) + wx;
-				emp_tile_t* tile = &G->level->tiles[di];
-				emp_tile_health_t* health = &G->level->health[di];
-
-				if (value == 2) {
-					if (health->value == 0) {
-						continue;
-					}
+// Buckets the tile and decoration descriptors of every sublevel by chunk
+// with a counting sort, so rendering only walks the chunks in view.
+static void level_chunks_build(emp_level_asset_t* level)
+{
+	emp_level_chunks_t* chunks = G->chunks;
+	level_chunks_release_textures();
+	SDL_memset(chunks->tile_start, 0, sizeof(chunks->tile_start));
+	SDL_memset(chunks->deco_start, 0, sizeof(chunks->deco_start));
+
+	for (int pass = 0; pass < 2; ++pass) {
+		for (u64 li = 0; li < level->sublevels.count; li++) {
+			emp_sublevel_t* sublevel = level->sublevels.entries + li;
+			u64 tile_count = sublevel_on_tile_grid(sublevel) ? sublevel->tiles.count : 0;
+
+			for (u64 ti = 0; ti < tile_count; ti++) {
+				const emp_tile_desc_t* desc = sublevel->tiles.values + ti;
+				emp_vec2_t pos = emp_tile_world_pos(sublevel, desc);
+				u64 di;
+				if (!level_tile_index(pos, EMP_TILE_SIZE, &di)) {
+					continue;
 				}
+				u32 chunk = level_chunk_of_tile(di);
+				if (pass == 0) {
+					chunks->tile_start[chunk + 1]++;
+				} else {
+					chunks->tiles[chunks->tile_start[chunk]++] = (emp_chunk_ref_t) { .sublevel = (u32)li, .desc = (u32)ti };
+				}
+			}
 
-				SDL_FRect dst = render_rect_tile(pos, grid_size);
-				SDL_RenderTexture(G->renderer, texture->texture, &src, &dst);
-
-				if (value == 1) {
-					tile->state = emp_tile_state_occupied;
-					draw_rect_at(pos, grid_size, 255, 0, 0, 255);
+			for (u64 ti = 0; ti < sublevel->decoration.tiles.count; ti++) {
+				const emp_tile_desc_t* desc = sublevel->decoration.tiles.values + ti;
+				emp_vec2_t pos = emp_tile_world_pos(sublevel, desc);
+				u64 di;
+				if (!level_tile_index(pos, EMP_TILE_SIZE, &di)) {
+					continue;
 				}
-				if (value == 2) {
-					tile->state = emp_tile_state_breakable;
-					draw_rect_at(pos, grid_size, 255, 255, 0, 255);
+				u32 chunk = level_chunk_of_tile(di);
+				if (pass == 0) {
+					chunks->deco_start[chunk + 1]++;
+				} else {
+					chunks->decorations[chunks->deco_start[chunk]++] = (emp_chunk_ref_t) { .sublevel = (u32)li, .desc = (u32)ti };
 				}
 			}
 		}
-		if (deco != NULL) {
-			for (u64 ti = 0; ti < sublevel->decoration.tiles.count; ti++) {
-				emp_tile_desc_t* desc = sublevel->decoration.tiles.values + ti;
-				// SDL_FRect animated = source_rect(deco);
-				SDL_FRect src = { desc->src.x, (float)desc->src.y, (float)deco->source_size, (float)deco->source_size };
-				float value = (float)G->args->global_time / DECO_ANIMATION_SPEED;
+
+		if (pass == 0) {
+			for (u32 c = 1; c <= EMP_LEVEL_CHUNKS; ++c) {
+				chunks->tile_start[c] += chunks->tile_start[c - 1];
+				chunks->deco_start[c] += chunks->deco_start[c - 1];
+			}
+			u32 tile_count = chunks->tile_start[EMP_LEVEL_CHUNKS];
+			u32 deco_count = chunks->deco_start[EMP_LEVEL_CHUNKS];
+			chunks->tiles = SDL_realloc(chunks->tiles, sizeof(emp_chunk_ref_t) * (tile_count ? tile_count : 1));
+			chunks->decorations = SDL_realloc(chunks->decorations, sizeof(emp_chunk_ref_t) * (deco_count ? deco_count : 1));
+		}
+	}
+
+	// The scatter advanced every start to the next chunk's; shift back.
+	for (u32 c = EMP_LEVEL_CHUNKS; c > 0; --c) {
+		chunks->tile_start[c] = chunks->tile_start[c - 1];
+		chunks->deco_start[c] = chunks->deco_start[c - 1];
+	}
+	chunks->tile_start[0] = 0;
+	chunks->deco_start[0] = 0;
+
+	SDL_memset(G->level->chunk_dirty, 0xff, sizeof(G->level->chunk_dirty));
+}
+
+// Draws the static tiles of a chunk into its cached render target. Texel
+// (0, 0) is the top-left corner of the chunk's first tile.
+static void level_chunk_bake(u32 chunk)
+{
+	emp_level_chunks_t* chunks = G->chunks;
+	emp_level_asset_t* level = (emp_level_asset_t*)G->assets->ldtk->world.handle;
+
+	SDL_Texture** target = &chunks->textures[chunk];
+	if (*target == NULL) {
+		*target = SDL_CreateTexture(G->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, EMP_CHUNK_PIXELS, EMP_CHUNK_PIXELS);
+		if (*target == NULL) {
+			return;
+		}
+		SDL_SetTextureScaleMode(*target, SDL_SCALEMODE_NEAREST);
+		// Tile texels are either opaque or fully transparent, so plain alpha
+		// blending of the baked result matches drawing the tiles directly.
+		SDL_SetTextureBlendMode(*target, SDL_BLENDMODE_BLEND);
+	}
+
+	if (g_bake_batch.layer_count == 0) {
+		emp_sprite_batch_init(&g_bake_batch, 1);
+	}
+
+	emp_vec2_t base = {
+		.x = (float)(chunk % EMP_LEVEL_CHUNKS_X) * (float)EMP_CHUNK_PIXELS,
+		.y = (float)(chunk / EMP_LEVEL_CHUNKS_X) * (float)EMP_CHUNK_PIXELS,
+	};
+
+	for (u32 i = chunks->tile_start[chunk]; i < chunks->tile_start[chunk + 1]; ++i) {
+		emp_chunk_ref_t ref = chunks->tiles[i];
+		emp_sublevel_t* sublevel = level->sublevels.entries + ref.sublevel;
+		emp_texture_t* texture = emp_texture_find(sublevel->tiles.tilemap);
+		if (texture == NULL) {
+			continue;
+		}
+
+		float grid_size = sublevel->values.grid_size;
+		const emp_tile_desc_t* desc = sublevel->tiles.values + ref.desc;
+		u64 lx = (u64)(desc->dst.x / grid_size);
+		u64 ly = (u64)(desc->dst.y / grid_size);
+
+		size_t index = (size_t)(ly * sublevel->values.grid_width) + (size_t)lx;
+		u8 value = sublevel->values.entries[index];
+
+		emp_vec2_t pos = emp_tile_world_pos(sublevel, desc);
+		u64 di;
+		if (!level_tile_index(pos, grid_size, &di)) {
+			continue;
+		}
+		if (value == 2 && G->level->health[di].value == 0) {
+			continue;
+		}
+
+		SDL_FRect src = { texture->x + desc->src.x, texture->y + desc->src.y, grid_size, grid_size };
+		SDL_FRect dst = { pos.x - base.x, pos.y - base.y, grid_size, grid_size };
+		emp_sprite_batch_draw(&g_bake_batch, 0, texture->texture, &src, &dst, EMP_SPRITE_WHITE);
+	}
+
+	SDL_Texture* previous = SDL_GetRenderTarget(G->renderer);
+	u8 r, g, b, a;
+	SDL_GetRenderDrawColor(G->renderer, &r, &g, &b, &a);
+
+	SDL_SetRenderTarget(G->renderer, *target);
+	SDL_SetRenderDrawColor(G->renderer, 0, 0, 0, 0);
+	SDL_RenderClear(G->renderer);
+	emp_sprite_batch_flush(&g_bake_batch, G->renderer);
+
+	SDL_SetRenderTarget(G->renderer, previous);
+	SDL_SetRenderDrawColor(G->renderer, r, g, b, a);
+}
+
+// Trims a quad to the part inside the view, adjusting `src` to match. Chunk
+// quads are mostly off-screen; submitting only the visible part saves fill,
+// and the software renderer mishandles blended blits it has to clip itself.
+static bool clip_to_view(SDL_FRect* src, SDL_FRect* dst)
+{
+	float scale_x = dst->w / src->w;
+	float scale_y = dst->h / src->h;
+
+	if (dst->x < 0.0f) {
+		src->x -= dst->x / scale_x;
+		src->w += dst->x / scale_x;
+		dst->w += dst->x;
+		dst->x = 0.0f;
+	}
+	if (dst->y < 0.0f) {
+		src->y -= dst->y / scale_y;
+		src->h += dst->y / scale_y;
+		dst->h += dst->y;
+		dst->y = 0.0f;
+	}
+
+	float over_x = dst->x + dst->w - G->view_size.x;
+	if (over_x > 0.0f) {
+		dst->w -= over_x;
+		src->w -= over_x / scale_x;
+	}
+	float over_y = dst->y + dst->h - G->view_size.y;
+	if (over_y > 0.0f) {
+		dst->h -= over_y;
+		src->h -= over_y / scale_y;
+	}
+
+	return dst->w > 0.0f && dst->h > 0.0f;
+}
+
+void emp_level_render(void)
+{
+	emp_level_chunks_t* chunks = G->chunks;
+	emp_level_asset_t* level_asset = (emp_level_asset_t*)G->assets->ldtk->world.handle;
+
+	// Tiles are centred on their grid position, so chunk c starts half a tile
+	// before c * EMP_CHUNK_PIXELS in world space.
+	float half = EMP_TILE_SIZE / 2.0f;
+	emp_vec2_t offset = render_offset();
+	float view_min_x = G->camera.x - offset.x / SPRITE_MAGNIFICATION + half;
+	float view_min_y = G->camera.y - offset.y / SPRITE_MAGNIFICATION + half;
+	float view_max_x = G->camera.x + (G->view_size.x - offset.x) / SPRITE_MAGNIFICATION + half;
+	float view_max_y = G->camera.y + (G->view_size.y - offset.y) / SPRITE_MAGNIFICATION + half;
+
+	// Decoration sprites can hang over the edge of their chunk.
+	float margin = EMP_TILE_SIZE * 2.0f;
+	i32 cx0 = SDL_clamp((i32)SDL_floorf((view_min_x - margin) / EMP_CHUNK_PIXELS), 0, EMP_LEVEL_CHUNKS_X - 1);
+	i32 cy0 = SDL_clamp((i32)SDL_floorf((view_min_y - margin) / EMP_CHUNK_PIXELS), 0, EMP_LEVEL_CHUNKS_Y - 1);
+	i32 cx1 = SDL_clamp((i32)SDL_floorf((view_max_x + margin) / EMP_CHUNK_PIXELS), 0, EMP_LEVEL_CHUNKS_X - 1);
+	i32 cy1 = SDL_clamp((i32)SDL_floorf((view_max_y + margin) / EMP_CHUNK_PIXELS), 0, EMP_LEVEL_CHUNKS_Y - 1);
+
+	for (i32 cy = cy0; cy <= cy1; ++cy) {
+		for (i32 cx = cx0; cx <= cx1; ++cx) {
+			u32 chunk = (u32)(cy * EMP_LEVEL_CHUNKS_X + cx);
+			if (chunks->tile_start[chunk] == chunks->tile_start[chunk + 1]) {
+				continue;
+			}
+
+			u64 dirty_bit = (u64)1 << (chunk & 63);
+			if (G->level->chunk_dirty[chunk >> 6] & dirty_bit) {
+				level_chunk_bake(chunk);
+				G->level->chunk_dirty[chunk >> 6] &= ~dirty_bit;
+			}
+
+			emp_vec2_t corner = world_to_screen((emp_vec2_t) {
+				.x = (float)cx * EMP_CHUNK_PIXELS - half,
+				.y = (float)cy * EMP_CHUNK_PIXELS - half,
+			});
+			float size = EMP_CHUNK_PIXELS * SPRITE_MAGNIFICATION;
+			SDL_FRect src = { 0.0f, 0.0f, (float)EMP_CHUNK_PIXELS, (float)EMP_CHUNK_PIXELS };
+			SDL_FRect dst = { SDL_floorf(corner.x), SDL_floorf(corner.y), size, size };
+			if (clip_to_view(&src, &dst)) {
+				emp_sprite_batch_draw(G->sprites, emp_layer_tiles, chunks->textures[chunk], &src, &dst, EMP_SPRITE_WHITE);
+			}
+		}
+	}
+
+	float value = (float)G->args->global_time / DECO_ANIMATION_SPEED;
+	for (i32 cy = cy0; cy <= cy1; ++cy) {
+		for (i32 cx = cx0; cx <= cx1; ++cx) {
+			u32 chunk = (u32)(cy * EMP_LEVEL_CHUNKS_X + cx);
+			for (u32 i = chunks->deco_start[chunk]; i < chunks->deco_start[chunk + 1]; ++i) {
+				emp_chunk_ref_t ref = chunks->decorations[i];
+				emp_sublevel_t* sublevel = level_asset->sublevels.entries + ref.sublevel;
+				emp_texture_t* deco = emp_texture_find(sublevel->decoration.tiles.tilemap);
+				if (deco == NULL) {
+					continue;
+				}
+
+				const emp_tile_desc_t* desc = sublevel->decoration.tiles.values + ref.desc;
+				SDL_FRect src = { (float)desc->src.x, deco->y + (float)desc->src.y, (float)deco->source_size, (float)deco->source_size };
 				u32 src_x = (u32)value % deco->columns;
-				src.x = (float)src_x * (float)deco->source_size;
+				src.x = deco->x + (float)src_x * (float)deco->source_size;
 
-				emp_vec2_t pos = emp_vec2_add(desc->dst, sublevel->offset);
+				emp_vec2_t pos = emp_tile_world_pos(sublevel, desc);
 
 				pos.y = pos.y - 4.0f;
 				SDL_FRect dst = render_rect_tile(pos, (float)deco->source_size);
-				SDL_RenderTexture(G->renderer, deco->texture, &src, &dst);
+				emp_sprite_batch_draw(G->sprites, emp_layer_decoration, deco->texture, &src, &dst, EMP_SPRITE_WHITE);
 			}
 		}
 	}
-	SDL_memset(G->level->enemy_in_tile, 0, sizeof(emp_enemy_t*) * EMP_LEVEL_TILES);
 }
 
 void emp_generator_uptdate(emp_bullet_generator_t* generator)
@@ -1314,46 +1841,51 @@ void emp_entities_init()
 {
 	G->player = SDL_malloc(sizeof(emp_player_t) * EMP_MAX_PLAYERS);
 	G->enemies = SDL_malloc(sizeof(emp_enemy_t) * EMP_MAX_ENEMIES);
-	G->bullets = SDL_malloc(sizeof(emp_bullet_t) * EMP_MAX_BULLETS);
+	G->bullets = SDL_malloc(sizeof(emp_bullets_t));
 	G->generators = SDL_malloc(sizeof(emp_bullet_generator_t) * EMP_MAX_BULLET_GENERATORS);
 	G->spawners = SDL_malloc(sizeof(emp_spawner_t) * EMP_MAX_SPAWNERS);
+	G->sprites = SDL_malloc(sizeof(emp_sprite_batch_t));
+	G->chunks = SDL_malloc(sizeof(emp_level_chunks_t));
+	SDL_zerop(G->chunks);
 
 	SDL_memset(G->player, 0, sizeof(emp_player_t) * EMP_MAX_PLAYERS);
 	SDL_memset(G->enemies, 0, sizeof(emp_enemy_t) * EMP_MAX_ENEMIES);
-	SDL_memset(G->bullets, 0, sizeof(emp_bullet_t) * EMP_MAX_BULLETS);
 	SDL_memset(G->generators, 0, sizeof(emp_bullet_generator_t) * EMP_MAX_BULLET_GENERATORS);
 	SDL_memset(G->spawners, 0, sizeof(emp_spawner_t) * EMP_MAX_SPAWNERS);
+
+	emp_bullets_init(G->bullets, EMP_MAX_BULLETS);
+	emp_sprite_batch_init(G->sprites, emp_layer_count);
+	emp_pool_init(&G->enemy_pool, EMP_MAX_ENEMIES);
+	emp_pool_init(&G->bullet_pool, EMP_MAX_BULLETS);
+	emp_pool_init(&G->spawner_pool, EMP_MAX_SPAWNERS);
+	emp_pool_init(&G->generator_pool, EMP_MAX_BULLET_GENERATORS);
+	emp_spatial_hash_init(&G->enemy_grid, EMP_TILE_SIZE);
+	SDL_zero(G->input);
+	SDL_zero(G->camera);
 }
 
-int emp_teleporter_uptdate(emp_level_teleporter_t const* teleporter)
+static emp_vec2_t teleporter_pos(emp_level_teleporter_t const* teleporter)
 {
-	emp_asset_t* texture_asset = &G->assets->png->cave_32;
-	emp_texture_t* texture = texture_asset->handle;
-	SDL_FRect src = source_rect(texture);
-	emp_vec2_t pos = (emp_vec2_t) {
+	return (emp_vec2_t) {
 		.x = teleporter->x - (float)EMP_TILE_SIZE / 2,
 		.y = teleporter->y - (float)EMP_TILE_SIZE / 2,
 	};
-	SDL_FRect dst = render_rect(pos, texture);
+}
 
-	emp_vec2_t centre = (emp_vec2_t) { .x = dst.x + (dst.w / 2), .y = dst.y + (dst.h / 2) };
+static bool teleporter_is_hovered(emp_vec2_t mouse_pos, emp_vec2_t pos)
+{
+	return emp_vec2_dist(mouse_pos, world_to_screen(pos)) < EMP_TILE_SIZE * SPRITE_MAGNIFICATION;
+}
+
+int emp_teleporter_uptdate(emp_level_teleporter_t const* teleporter)
+{
+	emp_vec2_t pos = teleporter_pos(teleporter);
 
 	int on_teleporter = 0;
 	float distance = emp_vec2_dist(G->player->pos, pos);
 
-	emp_vec2_t mouse_pos;
-	SDL_MouseButtonFlags buttons = SDL_GetMouseState(&mouse_pos.x, &mouse_pos.y);
-	int is_hovering = emp_vec2_dist(mouse_pos, centre) < EMP_TILE_SIZE * SPRITE_MAGNIFICATION;
 	if (distance < EMP_TILE_SIZE) {
-		if (is_hovering) {
-			float ex = dst.w * 0.25f;
-			float ey = dst.h * 0.25f;
-			dst.w = dst.w + ex;
-			dst.h = dst.h + ey;
-			dst.x = dst.x - (ex * 0.5f);
-			dst.y = dst.y - (ex * 0.5f);
-		}
-		if (buttons & SDL_BUTTON_MASK(SDL_BUTTON_RIGHT) && is_hovering) {
+		if (G->input.buttons & SDL_BUTTON_MASK(SDL_BUTTON_RIGHT) && teleporter_is_hovered(G->input.mouse, pos)) {
 			if (G->player->is_teleporting == 0 /*&& G->player->was_teleporting == 0*/) {
 				emp_level_asset_t* level = (emp_level_asset_t*)G->assets->ldtk->world.handle;
 				u32 found = emp_level_teleporter_list_find(&level->teleporters, teleporter->other);
@@ -1363,8 +1895,11 @@ int emp_teleporter_uptdate(emp_level_teleporter_t const* teleporter)
 
 					G->player->pos.x = tp->x - (EMP_TILE_SIZE / 2.0f);
 					G->player->pos.y = tp->y - (EMP_TILE_SIZE / 2.0f);
+					// Jump cut rather than sweeping the view across the level.
+					G->player->prev_pos = G->player->pos;
+					G->camera = G->player->pos;
 					G->player->is_teleporting = 1;
-					play_one_shot(&G->assets->ogg->teleport);
+					play_one_shot(&G->assets->ogg->teleport, G->player->pos);
 
 					emp_ka_ching(G->player->pos);
 				}
@@ -1375,17 +1910,32 @@ int emp_teleporter_uptdate(emp_level_teleporter_t const* teleporter)
 		}
 	}
 
-	if (G->player->is_teleporting) {
+	return on_teleporter;
+}
 
-		SDL_SetTextureAlphaMod(texture->texture, 64);
-		SDL_RenderTexture(G->renderer, texture->texture, &src, &dst);
-		SDL_SetTextureAlphaMod(texture->texture, 255);
-	} else {
-		SDL_RenderTexture(G->renderer, texture->texture, &src, &dst);
+void emp_teleporter_render(emp_level_teleporter_t const* teleporter)
+{
+	emp_asset_t* texture_asset = &G->assets->png->cave_32;
+	emp_texture_t* texture = texture_asset->handle;
+	SDL_FRect src = source_rect(texture);
+	emp_vec2_t pos = teleporter_pos(teleporter);
+	SDL_FRect dst = render_rect(pos, texture);
+
+	if (emp_vec2_dist(G->player->pos, pos) < EMP_TILE_SIZE) {
+		if (teleporter_is_hovered(G->input.mouse, pos)) {
+			float ex = dst.w * 0.25f;
+			float ey = dst.h * 0.25f;
+			dst.w = dst.w + ex;
+			dst.h = dst.h + ey;
+			dst.x = dst.x - (ex * 0.5f);
+			dst.y = dst.y - (ex * 0.5f);
+		}
 	}
 
+	SDL_FColor color = G->player->is_teleporting ? emp_sprite_color(255, 255, 255, 64) : EMP_SPRITE_WHITE;
+	emp_sprite_batch_draw(G->sprites, emp_layer_teleporter, texture->texture, &src, &dst, color);
+
 	draw_rect_at(pos, teleporter->w, 255, 0, 0, 255);
-	return on_teleporter;
 }
 
 void emp_spawner_update(u32 index, emp_spawner_t* spawner)
@@ -1401,26 +1951,55 @@ void emp_spawner_update(u32 index, emp_spawner_t* spawner)
 			spawner->accumulator = spawner->accumulator + spawner->frequency;
 			spawner->count = spawner->count + 1;
 
-			emp_create_enemy(pos, spawner->enemy_conf_index, spawner->enemy_health, spawner->movement_speed, spawner->weapon_index, (emp_spawner_h) { .index = index });
+			emp_spawner_h spawned_by = { .index = index, .generation = emp_pool_generation(&G->spawner_pool, index) };
+			emp_create_enemy(pos, spawner->enemy_conf_index, spawner->enemy_health, spawner->movement_speed, spawner->weapon_index, spawned_by);
 		}
 	}
+}
+
+void emp_spawner_render(emp_spawner_t const* spawner)
+{
+	emp_vec2_t pos = (emp_vec2_t) { .x = spawner->x, .y = spawner->y };
+	float dist = emp_vec2_dist(G->player->pos, pos);
+	if (dist > 450.0f) {
+		return;
+	}
 
 	emp_asset_t* texture_asset = &G->assets->png->cave2_32;
 	emp_texture_t* texture = texture_asset->handle;
 	SDL_FRect src = source_rect(texture);
 	SDL_FRect dst = render_rect(pos, texture);
-	SDL_RenderTexture(G->renderer, texture->texture, &src, &dst);
+	emp_sprite_batch_draw(G->sprites, emp_layer_spawner, texture->texture, &src, &dst, EMP_SPRITE_WHITE);
 }
 
-void emp_entities_update()
+// Remembers where everything starts the step so emp_render can blend
+// towards where it ends up.
+static void store_previous_positions(void)
 {
-	emp_level_update();
-	emp_music_player_update(G->music_player);
+	for (u64 i = 0; i < EMP_MAX_PLAYERS; ++i) {
+		G->player[i].prev_pos = G->player[i].pos;
+	}
+	for (u32 i = 0; i < G->enemy_pool.count; ++i) {
+		emp_enemy_t* enemy = &G->enemies[G->enemy_pool.dense[i]];
+		enemy->prev_pos = enemy->pos;
+	}
+	emp_bullets_t* bullets = G->bullets;
+	SDL_memcpy(bullets->px, bullets->x, sizeof(*bullets->x) * G->bullet_pool.count);
+	SDL_memcpy(bullets->py, bullets->y, sizeof(*bullets->y) * G->bullet_pool.count);
+}
+
+void emp_simulate(double dt)
+{
+	G->args->dt = (float)dt;
+	G->args->global_time += dt;
+
+	store_previous_positions();
+	G->camera = G->player->pos;
 
 	int is_teleporting = 0;
 	emp_level_asset_t* level = (emp_level_asset_t*)G->assets->ldtk->world.handle;
-	for (u64 i = 0; i < SDL_arraysize(level->teleporters.entries); i++) {
-		emp_level_teleporter_t* tp = level->teleporters.entries + i;
+	for (u64 i = 0; i < level->teleporters.capacity; i++) {
+		const emp_level_teleporter_t* tp = level->teleporters.entries + i;
 		if (tp->id != 0) {
 			is_teleporting = emp_teleporter_uptdate(tp) || is_teleporting;
 		}
@@ -1432,63 +2011,94 @@ void emp_entities_update()
 		emp_player_update(player);
 	}
 
-	for (u64 i = 0; i < EMP_MAX_ENEMIES; ++i) {
-		emp_enemy_t* enemy = &G->enemies[i];
-		if (enemy->alive) {
-			emp_enemy_update(enemy);
-		}
+	// Live sets are walked backwards: entities may free themselves, and new
+	// ones appended during the loop are left for the next frame.
+	emp_spatial_hash_clear(&G->enemy_grid);
+	for (u32 i = G->enemy_pool.count; i-- > 0;) {
+		u32 index = G->enemy_pool.dense[i];
+		emp_enemy_update(index, &G->enemies[index]);
 	}
+	emp_spatial_hash_build(&G->enemy_grid);
 
-	for (u64 i = 0; i < EMP_MAX_BULLETS; ++i) {
-		emp_bullet_t* bullet = &G->bullets[i];
-		if (bullet->alive) {
-			emp_bullet_update(bullet);
-		}
+	emp_bullets_integrate(G->bullets, G->bullet_pool.count, G->args->dt);
+	for (u32 at = G->bullet_pool.count; at-- > 0;) {
+		emp_bullet_update(at);
 	}
 
-	for (u32 i = 0; i < EMP_MAX_SPAWNERS; ++i) {
-		emp_spawner_t* spawner = &G->spawners[i];
-		if (spawner->alive) {
-			emp_spawner_update(i, spawner);
-		}
+	for (u32 i = G->spawner_pool.count; i-- > 0;) {
+		u32 index = G->spawner_pool.dense[i];
+		emp_spawner_update(index, &G->spawners[index]);
 	}
 
-	for (u64 i = 0; i < EMP_MAX_BULLET_GENERATORS; ++i) {
-		emp_bullet_generator_t* generator = &G->generators[i];
-		if (generator->alive) {
-			emp_generator_uptdate(generator);
-		}
+	for (u32 i = G->generator_pool.count; i-- > 0;) {
+		u32 index = G->generator_pool.dense[i];
+		emp_generator_uptdate(&G->generators[index]);
 	}
 
 	//  LATE UPDATES
 
-	for (u64 i = 0; i < EMP_MAX_ENEMIES; ++i) {
-		emp_enemy_t* enemy = &G->enemies[i];
-		if (enemy->alive) {
-			emp_enemy_late_update(enemy);
+	for (u32 i = G->enemy_pool.count; i-- > 0;) {
+		u32 index = G->enemy_pool.dense[i];
+		emp_enemy_late_update(index, &G->enemies[index]);
+	}
+}
+
+void emp_render(float alpha)
+{
+	render_alpha = alpha;
+	G->camera = interpolate(G->player->prev_pos, G->player->pos);
+
+	emp_level_render();
+
+	emp_level_asset_t* level = (emp_level_asset_t*)G->assets->ldtk->world.handle;
+	for (u64 i = 0; i < level->teleporters.capacity; i++) {
+		const emp_level_teleporter_t* tp = level->teleporters.entries + i;
+		if (tp->id != 0) {
+			emp_teleporter_render(tp);
 		}
 	}
+
+	for (u64 i = 0; i < EMP_MAX_PLAYERS; ++i) {
+		emp_player_render(&G->player[i]);
+	}
+
+	for (u32 i = G->enemy_pool.count; i-- > 0;) {
+		emp_enemy_render(&G->enemies[G->enemy_pool.dense[i]]);
+	}
+
+	for (u32 at = G->bullet_pool.count; at-- > 0;) {
+		emp_bullet_render(at);
+	}
+
+	for (u32 i = G->spawner_pool.count; i-- > 0;) {
+		emp_spawner_render(&G->spawners[G->spawner_pool.dense[i]]);
+	}
 }
 
 void setup_level(emp_asset_t* level_asset)
 {
 	SDL_memset(G->enemies, 0, sizeof(emp_enemy_t) * EMP_MAX_ENEMIES);
-	SDL_memset(G->bullets, 0, sizeof(emp_bullet_t) * EMP_MAX_BULLETS);
 	SDL_memset(G->generators, 0, sizeof(emp_bullet_generator_t) * EMP_MAX_BULLET_GENERATORS);
 	SDL_memset(G->spawners, 0, sizeof(emp_spawner_t) * EMP_MAX_SPAWNERS);
 
+	emp_pool_clear(&G->enemy_pool);
+	emp_pool_clear(&G->bullet_pool);
+	emp_pool_clear(&G->spawner_pool);
+	emp_pool_clear(&G->generator_pool);
+
 	u32 player = emp_create_player();
 	G->player[player].texture_asset = &G->assets->png->player_32;
 
 	emp_level_asset_t* level = (emp_level_asset_t*)level_asset->handle;
 	u32 found = emp_level_query(level, emp_entity_type_player, 0);
 	if (found) {
-		emp_level_entity_t* player_entity = emp_level_get(level, found - 1);
+		const emp_level_entity_t* player_entity = emp_level_get(level, found - 1);
 		float half = level->entities.grid_size * 0.5f;
 		float x = player_entity->x - half;
 		float y = player_entity->y - half;
 		G->player[player].pos.x = x;
 		G->player[player].pos.y = y;
+		G->player[player].prev_pos = G->player[player].pos;
 		G->player[player].movement_speed = player_entity->movement_speed;
 	} else {
 		SDL_Log("No Player config broke!");
@@ -1501,7 +2111,7 @@ void setup_level(emp_asset_t* level_asset)
 			break;
 		}
 
-		emp_level_entity_t* spawner = emp_level_get(level, found - 1);
+		const emp_level_entity_t* spawner = emp_level_get(level, found - 1);
 		emp_vec2_t pos = (emp_vec2_t) {
 			.x = spawner->x - (float)EMP_TILE_SIZE / 2,
 			.y = spawner->y - (float)EMP_TILE_SIZE / 2,
@@ -1526,16 +2136,16 @@ void setup_level(emp_asset_t* level_asset)
 		}
 
 		float half = level->entities.grid_size * 0.5f;
-		emp_level_entity_t* boss = emp_level_get(level, found - 1);
+		const emp_level_entity_t* boss = emp_level_get(level, found - 1);
 		float x = boss->x - half;
 		float y = boss->y - half;
 
 		switch (boss->behaviour) {
 		case emp_behaviour_type_roamer:
-			emp_create_enemy((emp_vec2_t) { x, y }, 1, 0.0f, boss->movement_speed, boss->weapon_index, (emp_spawner_h) { .index = EMP_MAX_SPAWNERS });
+			emp_create_enemy((emp_vec2_t) { x, y }, 1, 0.0f, boss->movement_speed, boss->weapon_index, (emp_spawner_h) { 0 });
 			break;
 		case emp_behaviour_type_chaser:
-			emp_create_enemy((emp_vec2_t) { x, y }, 3, 0.0f, boss->movement_speed, boss->weapon_index, (emp_spawner_h) { .index = EMP_MAX_SPAWNERS });
+			emp_create_enemy((emp_vec2_t) { x, y }, 3, 0.0f, boss->movement_speed, boss->weapon_index, (emp_spawner_h) { 0 });
 			break;
 		default:
 			break;
@@ -1550,7 +2160,7 @@ void setup_level(emp_asset_t* level_asset)
 		}
 
 		float half = level->entities.grid_size * 0.5f;
-		emp_level_entity_t* chest = emp_level_get(level, found - 1);
+		const emp_level_entity_t* chest = emp_level_get(level, found - 1);
 		float x = chest->x - half;
 		float y = chest->y - half;
 		emp_create_chest((emp_vec2_t) { x, y }, chest->weapon_index);
@@ -1558,52 +2168,117 @@ void setup_level(emp_asset_t* level_asset)
 
 	for (u64 li = 0; li < level->sublevels.count; li++) {
 		emp_sublevel_t* sublevel = level->sublevels.entries + li;
+		if (!sublevel_on_tile_grid(sublevel)) {
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Sublevel %llu uses a %g px grid, expected %g px; its tiles are skipped",
+				(unsigned long long)li, (double)sublevel->values.grid_size, (double)EMP_TILE_SIZE);
+			continue;
+		}
 		for (u64 ti = 0; ti < sublevel->tiles.count; ti++) {
 			float grid_size = sublevel->values.grid_size;
-			emp_tile_desc_t* desc = sublevel->tiles.values + ti;
+			const emp_tile_desc_t* desc = sublevel->tiles.values + ti;
 			u64 lx = (u64)(desc->dst.x / grid_size);
 			u64 ly = (u64)(desc->dst.y / grid_size);
 
 			size_t index = (size_t)(ly * sublevel->values.grid_width) + (size_t)lx;
 			u8 value = sublevel->values.entries[index];
 
-			emp_vec2_t pos = emp_vec2_add(desc->dst, sublevel->offset);
+			emp_vec2_t pos = emp_tile_world_pos(sublevel, desc);
 			u64 wx = (u64)(pos.x / grid_size);
 			u64 wy = (u64)(pos.y / grid_size);
 
 			u64 di = (wy * EMP_LEVEL_WIDTH) + wx;
 			emp_tile_health_t* health = &G->level->health[di];
+			if (value == 1) {
+				tile_bit_set(G->level->walls, di);
+			}
 			if (value == 2) {
 				health->value = 2;
+				tile_bit_set(G->level->breakable, di);
 			}
 		}
 	}
+
+	level_chunks_build(level);
+}
+
+SDL_COMPILE_TIME_ASSERT(tile_health_is_byte, sizeof(emp_tile_health_t) == 1);
+
+void emp_level_rebuild_breakable(void)
+{
+	u64* breakable = G->level->breakable;
+	emp_tile_health_t* health = G->level->health;
+	for (u64 word = 0; word < EMP_LEVEL_TILE_WORDS; ++word) {
+		// Most of the grid is empty; test 64 tiles eight bytes at a time first.
+		u64 any = 0;
+		for (u64 lane = 0; lane < 8; ++lane) {
+			u64 packed;
+			SDL_memcpy(&packed, health + word * 64 + lane * 8, sizeof(packed));
+			any |= packed;
+		}
+
+		u64 bits = 0;
+		for (u64 bit = 0; any && bit < 64; ++bit) {
+			bits |= (u64)(health[word * 64 + bit].value != 0) << bit;
+		}
+
+		// A word spans two chunks; re-bake whichever halves changed.
+		u64 changed = breakable[word] ^ bits;
+		if (changed & 0xffffffffull) {
+			level_chunk_mark_dirty(level_chunk_of_tile(word * 64));
+		}
+		if (changed >> 32) {
+			level_chunk_mark_dirty(level_chunk_of_tile(word * 64 + 32));
+		}
+		breakable[word] = bits;
+	}
+}
+
+void emp_level_invalidate_chunks(void)
+{
+	SDL_memset(G->level->chunk_dirty, 0xff, sizeof(G->level->chunk_dirty));
+}
+
+void emp_level_release_chunks(void)
+{
+	level_chunks_release_textures();
+	emp_level_invalidate_chunks();
 }
 
 void emp_create_level(emp_asset_t* level_asset, int is_reload)
 {
 	if (!is_reload) {
 		G->level = SDL_malloc(sizeof(emp_level_t));
-		G->level->tiles = SDL_malloc(sizeof(*G->level->tiles) * EMP_LEVEL_TILES);
+		G->level->walls = SDL_malloc(sizeof(u64) * EMP_LEVEL_TILE_WORDS);
+		G->level->breakable = SDL_malloc(sizeof(u64) * EMP_LEVEL_TILE_WORDS);
 		G->level->health = SDL_malloc(sizeof(*G->level->health) * EMP_LEVEL_TILES);
-		G->level->enemy_in_tile = SDL_malloc(sizeof(emp_enemy_t*) * EMP_LEVEL_TILES);
 	}
-	emp_tile_t* tiles = G->level->tiles;
+	u64* walls = G->level->walls;
+	u64* breakable = G->level->breakable;
 	emp_tile_health_t* health = G->level->health;
-	emp_enemy_t** enemy_in_tile = G->level->enemy_in_tile;
-	SDL_memset(G->level->tiles, 0, sizeof(*G->level->tiles) * EMP_LEVEL_TILES);
-	SDL_memset(G->level->health, 0, sizeof(*G->level->health) * EMP_LEVEL_TILES);
-	SDL_memset(G->level->enemy_in_tile, 0, sizeof(emp_enemy_t*) * EMP_LEVEL_TILES);
+	SDL_memset(walls, 0, sizeof(u64) * EMP_LEVEL_TILE_WORDS);
+	SDL_memset(breakable, 0, sizeof(u64) * EMP_LEVEL_TILE_WORDS);
+	SDL_memset(health, 0, sizeof(*G->level->health) * EMP_LEVEL_TILES);
 	SDL_zerop(G->level);
-	G->level->tiles = tiles;
+	G->level->walls = walls;
+	G->level->breakable = breakable;
 	G->level->health = health;
-	G->level->enemy_in_tile = enemy_in_tile;
 	SDL_Log("%s", level_asset->path);
 	setup_level(&G->assets->ldtk->world);
+	// Every chunk differs from whatever keyframe predates the (re)load.
+	SDL_memset(G->level->health_dirty, 0xff, sizeof(G->level->health_dirty));
 }
 
 void emp_destroy_level(void)
 {
-	SDL_free(G->level->tiles);
+	level_chunks_release_textures();
+	SDL_free(G->chunks->tiles);
+	SDL_free(G->chunks->decorations);
+	G->chunks->tiles = NULL;
+	G->chunks->decorations = NULL;
+
+	SDL_free(G->level->walls);
+	SDL_free(G->level->breakable);
+	SDL_free(G->level->health);
 	SDL_free(G->level);
+	G->level = NULL;
 }
\ No newline at end of file
@@ -2,15 +2,17 @@
 
 #include <Empire/types.h>
 #include <Empire/miniaudio.h>
+#include <Empire/pool.h>
+#include <Empire/spatial_hash.h>
+#include <Empire/sprite_batch.h>
 
 extern float SPRITE_MAGNIFICATION;
 
 typedef struct emp_asset_t emp_asset_t;
 typedef struct emp_enemy_t emp_enemy_t;
-typedef struct emp_bullet_t emp_bullet_t;
 
 typedef void (*emp_enemy_update_f)(emp_enemy_t*);
-typedef void (*emp_bullet_render_f)(emp_bullet_t*);
+typedef void (*emp_bullet_render_f)(u32 at);
 
 typedef struct emp_enemy_h
 {
@@ -27,6 +29,7 @@ typedef struct emp_bullet_h
 typedef struct emp_spawner_h
 {
 	u32 index;
+	u32 generation;
 } emp_spawner_h;
 
 typedef struct emp_bullet_generator_h
@@ -70,6 +73,8 @@ typedef struct emp_player_t
 	u32 generation;
 	u32 weapon_index;
 	emp_vec2_t pos;
+	// Position at the start of the current step, for render interpolation.
+	emp_vec2_t prev_pos;
 	emp_asset_t* texture_asset;
 	double last_shot;
 	bool is_teleporting;
@@ -85,14 +90,11 @@ typedef struct emp_player_t
 #define EMP_MAX_ENEMIES 256
 typedef struct emp_enemy_t
 {
-	emp_enemy_t* next_in_tile;
-
-	bool alive;
-	u32 generation;
 	float health;
 	float speed;
 	float enemy_shot_delay;
 	emp_vec2_t pos;
+	emp_vec2_t prev_pos;
 	emp_vec2_t direction;
 	emp_asset_t* texture_asset;
 	emp_weapon_conf_t* weapon;
@@ -109,7 +111,6 @@ typedef struct emp_enemy_t
 #define EMP_MAX_SPAWNERS 32
 typedef struct emp_spawner_t
 {
-	bool alive;
 	float x;
 	float y;
 	float health;
@@ -131,39 +132,36 @@ typedef enum bullet_mask {
 } bullet_mask;
 
 #define EMP_MAX_BULLETS 65535
-typedef struct emp_bullet_t
+// Bullets are stored as streams indexed by their position in bullet_pool's
+// dense array, so live bullets are always packed at [0, bullet_pool.count).
+// px/py hold the position at the start of the current step and are only
+// read when rendering.
+typedef struct emp_bullets_t
 {
-	bool alive;
-	u32 generation;
-	emp_vec2_t pos;
-	emp_vec2_t vel;
-	float life_left;
-	float damage;
-	emp_asset_t* texture_asset;
-	bullet_mask mask;
-	emp_bullet_render_f custom_render;
-} emp_bullet_t;
+	float* x;
+	float* y;
+	float* px;
+	float* py;
+	float* vx;
+	float* vy;
+	float* life;
+	float* damage;
+	bullet_mask* mask;
+	emp_asset_t** texture_asset;
+	emp_bullet_render_f* custom_render;
+} emp_bullets_t;
+
+void emp_bullets_init(emp_bullets_t* bullets, u32 capacity);
+void emp_bullets_move(emp_bullets_t* bullets, u32 from, u32 to);
+// Advances position and lifetime of bullets [0, count) by dt.
+void emp_bullets_integrate(emp_bullets_t* bullets, u32 count, float dt);
 
 #define EMP_MAX_BULLET_GENERATORS 1024
 typedef struct emp_bullet_generator_t
 {
-	bool alive;
-	u32 generation;
 	emp_weapon_conf_t weapons[16];
 } emp_bullet_generator_t;
 
-typedef enum emp_tile_state {
-	emp_tile_state_none,
-	emp_tile_state_occupied,
-	emp_tile_state_breakable
-} emp_tile_state;
-
-typedef struct emp_tile_t
-{
-	emp_tile_state state;
-	emp_enemy_h first_in_tile;
-} emp_tile_t;
-
 typedef struct emp_tile_health_t
 {
 	u8 value;
@@ -173,16 +171,106 @@ typedef struct emp_tile_health_t
 #define EMP_LEVEL_WIDTH 1024
 #define EMP_LEVEL_HEIGHT 1024
 #define EMP_LEVEL_TILES EMP_LEVEL_WIDTH * EMP_LEVEL_HEIGHT
+#define EMP_LEVEL_TILE_WORDS (EMP_LEVEL_TILES / 64)
+
+#define EMP_CHUNK_TILES 32
+#define EMP_CHUNK_PIXELS (EMP_CHUNK_TILES * (int)EMP_TILE_SIZE)
+#define EMP_LEVEL_CHUNKS_X (EMP_LEVEL_WIDTH / EMP_CHUNK_TILES)
+#define EMP_LEVEL_CHUNKS_Y (EMP_LEVEL_HEIGHT / EMP_CHUNK_TILES)
+#define EMP_LEVEL_CHUNKS (EMP_LEVEL_CHUNKS_X * EMP_LEVEL_CHUNKS_Y)
 
+// Collision is one bit per tile. `walls` is fixed once the level is set up;
+// a `breakable` bit is cleared when that tile's health reaches zero, which
+// also flags the tile's chunk in `chunk_dirty` for re-baking.
+// `health_dirty` flags chunks whose tile health changed since the last
+// rewind record, so a record only copies those chunks.
 typedef struct emp_level_t
 {
-	emp_tile_t* tiles;
-	emp_enemy_t** enemy_in_tile;
+	u64* walls;
+	u64* breakable;
 	emp_tile_health_t* health;
+	u64 chunk_dirty[EMP_LEVEL_CHUNKS / 64];
+	u64 health_dirty[EMP_LEVEL_CHUNKS / 64];
 } emp_level_t;
 
+typedef struct emp_chunk_ref_t
+{
+	u32 sublevel;
+	u32 desc;
+} emp_chunk_ref_t;
+
+// Render-side cache of the level in EMP_CHUNK_TILES square chunks. Static
+// tiles are baked into one target texture per chunk; animated decoration
+// is drawn per sprite but bucketed by chunk so it can be culled.
+// Chunk c owns tiles[tile_start[c]..tile_start[c + 1]).
+typedef struct emp_level_chunks_t
+{
+	SDL_Texture* textures[EMP_LEVEL_CHUNKS];
+	u32 tile_start[EMP_LEVEL_CHUNKS + 1];
+	u32 deco_start[EMP_LEVEL_CHUNKS + 1];
+	emp_chunk_ref_t* tiles;
+	emp_chunk_ref_t* decorations;
+} emp_level_chunks_t;
+
 typedef struct emp_music_player emp_music_player;
 
+// Handle of a loaded OGG asset. Sound effects are decoded once at load into
+// interleaved f32 PCM in the mixer's format, which every voice playing them
+// reads from. Music is left compressed and decoded as it streams.
+typedef struct emp_audio_t
+{
+	const void* data;
+	size_t size;
+	float* pcm;
+	ma_uint64 frame_count;
+} emp_audio_t;
+
+#define EMP_AUDIO_CHANNELS 2
+
+// Keys the simulation reads, one bit each in emp_input_t::keys.
+typedef enum emp_input_key {
+	emp_key_up,
+	emp_key_left,
+	emp_key_down,
+	emp_key_right,
+	emp_key_fire,
+	emp_key_kill,
+	emp_key_reload_level,
+	emp_key_rewind,
+	emp_key_weapon_1,
+	emp_key_weapon_8 = emp_key_weapon_1 + 7,
+	emp_key_count,
+} emp_input_key;
+
+// Input for one frame. The simulation reads this instead of SDL so a frame
+// can be fed from a recording. `mouse` is in window coordinates.
+typedef struct emp_input_t
+{
+	u32 keys;
+	u32 buttons;
+	emp_vec2_t mouse;
+} emp_input_t;
+
+static inline bool emp_input_down(const emp_input_t* input, emp_input_key key)
+{
+	return (input->keys >> key) & 1;
+}
+
+// Sprite batch layers, drawn in this order. Screen-space UI comes after every
+// world layer, so it is never covered by anything drawn in the world.
+typedef enum emp_layer {
+	emp_layer_tiles,
+	emp_layer_decoration,
+	emp_layer_teleporter,
+	emp_layer_player,
+	emp_layer_enemy,
+	emp_layer_bullet,
+	emp_layer_spawner,
+	emp_layer_text,
+	emp_layer_ui,
+	emp_layer_count,
+} emp_layer;
+
 typedef struct emp_entities_t
 {
 	SDL_Renderer* renderer;
@@ -190,10 +278,22 @@ typedef struct emp_entities_t
 	emp_generated_assets_o* assets;
 	emp_player_t* player;
 	emp_enemy_t* enemies;
-	emp_bullet_t* bullets;
+	emp_bullets_t* bullets;
 	emp_spawner_t* spawners;
 	emp_bullet_generator_t* generators;
+	emp_pool_t enemy_pool;
+	emp_pool_t bullet_pool;
+	emp_pool_t spawner_pool;
+	emp_pool_t generator_pool;
+	emp_spatial_hash_t enemy_grid;
 	emp_level_t* level;
+	emp_level_chunks_t* chunks;
+	emp_sprite_batch_t* sprites;
+	emp_vec2_t view_size;
+	// World position the view is centred on: the player's position while
+	// simulating, interpolated between steps while rendering.
+	emp_vec2_t camera;
+	emp_input_t input;
 	emp_music_player* music_player;
 	ma_engine* mixer;
 } emp_G;
@@ -201,16 +301,59 @@ typedef struct emp_entities_t
 extern emp_G* G;
 
 void emp_music_player_init(void);
+void emp_music_player_destroy(void);
+// Switches tracks by the player's position. Opening a track reads and sets
+// up its decoder, so this runs once per frame outside the fixed steps.
+void emp_music_player_update(emp_music_player* music);
 void emp_init_enemy_configs();
 void emp_init_weapon_configs();
 u32 emp_create_player();
+emp_enemy_h emp_create_enemy(emp_vec2_t pos, u32 enemy_conf_index, float health, float movement_speed, u32 weapon_index, emp_spawner_h spawned_by);
+emp_bullet_h emp_create_bullet();
 
 
+void emp_destroy_enemy(emp_enemy_h handle);
+void emp_destroy_bullet(emp_bullet_h handle);
+void emp_destroy_spawner(emp_spawner_h handle);
+
 emp_bullet_generator_h emp_create_bullet_generator();
 void emp_destroy_bullet_generator(emp_bullet_generator_h handle);
 
+bool emp_enemy_is_valid(emp_enemy_h handle);
+bool emp_bullet_is_valid(emp_bullet_h handle);
+bool emp_spawner_is_valid(emp_spawner_h handle);
+bool emp_bullet_generator_is_valid(emp_bullet_generator_h handle);
+
+// Queues a sound effect heard from `pos`. Requests are only collected
+// during the frame; emp_sound_flush merges and plays them.
+void play_one_shot(emp_asset_t* asset, emp_vec2_t pos);
+// Starts this frame's queued effects, one voice per asset, within the
+// voice budget. Call once per frame.
+void emp_sound_flush(void);
+// Stops any voice still reading `audio`'s PCM, before it is freed.
+void emp_stop_voices(emp_audio_t const* audio);
+
 void emp_entities_init();
-void emp_entities_update();
+// The simulation's random stream; seed it before creating the level for a
+// run that can be replayed.
+void emp_seed_rng(u32 seed);
+u32 emp_rng_state(void);
+// One simulation step of `dt` seconds. Touches no renderer state.
+void emp_simulate(double dt);
+// Draws the current state; never mutates the simulation. `alpha` in [0, 1]
+// is how far the frame is between the previous step and the latest one.
+void emp_render(float alpha);
+
+bool check_overlap_map(emp_vec2_t pos);
+float enemy_collision_radius(emp_enemy_t const* enemy);
+bool check_overlap_bullet_enemy(emp_vec2_t bullet_pos, emp_enemy_t* enemy);
 
 void emp_create_level(emp_asset_t* level_asset, int is_reload);
-void emp_destroy_level(void);
\ No newline at end of file
+void emp_destroy_level(void);
+// Re-derives the breakable collision bits from tile health, e.g. after a snapshot restore.
+void emp_level_rebuild_breakable(void);
+// Re-bakes every chunk, e.g. after a tileset was reloaded.
+void emp_level_invalidate_chunks(void);
+// Destroys the chunk render targets, e.g. after the render device was lost;
+// visible chunks are recreated and baked on the next frame.
+void emp_level_release_chunks(void);
\ No newline at end of file
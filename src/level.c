@@ -6,68 +6,110 @@
 #include <SDL3/SDL_log.h>
 #include <SDL3/SDL_stdinc.h>
 
-emp_sublevel_t* emp_level_create_sublevel(emp_level_asset_t* level, emp_value_grid_t* values, emp_tiles_data_t* tiles, emp_decoration_data_t* decoration)
+// Tiles the second pass left out because they do not fit the compiled form.
+typedef struct emp_level_skipped_t
 {
-	emp_sublevel_t* sublevel = level->sublevels.entries + level->sublevels.count;
-	level->sublevels.count = level->sublevels.count + 1;
-	sublevel->values = *values;
-	sublevel->tiles = *tiles;
-	sublevel->decoration = *decoration;
-	return sublevel;
-}
-
-emp_value_grid_t emp_level_reserve_values(emp_level_asset_t* level, u32 count)
+	// A coordinate past the 16 bits of emp_tile_pos_t.
+	u32 out_of_range;
+	// A world tile outside its sublevel's value grid.
+	u32 off_grid;
+} emp_level_skipped_t;
+
+// Second pass of the JSON loader: where the next tile, value, entity and
+// string of the level goes.
+typedef struct emp_level_writer_t
+{
+	emp_level_file_header_t* header;
+	emp_level_file_sublevel_t* sublevels;
+	emp_level_teleporter_t* teleporters;
+	emp_tile_desc_t* tiles;
+	u8* values;
+	char* strings;
+	emp_level_entity_t* entities;
+
+	u32 tile_count;
+	u32 value_count;
+	u32 string_size;
+	emp_level_skipped_t skipped;
+} emp_level_writer_t;
+
+// Tiles index the value grid by their position.
+static bool emp_level_tile_on_grid(const emp_tile_desc_t* desc, float grid_size, u32 grid_width, u32 grid_height)
 {
-	u8* data = level->values.values + level->values.count;
-	level->values.count = level->values.count + count;
-	return (emp_value_grid_t) { .entries = data, .count = count };
+	return grid_size >= 1.0f && (u32)(desc->dst.x / grid_size) < grid_width && (u32)(desc->dst.y / grid_size) < grid_height;
 }
 
-emp_tiles_data_t emp_level_reserve_tiles(emp_level_asset_t* level, u32 count)
+static u32 emp_level_add_string(emp_level_writer_t* writer, const char* str)
 {
-	emp_tile_desc_t* data = level->tiles.entries + level->tiles.count;
-	level->tiles.count = level->tiles.count + count;
-	return (emp_tiles_data_t) { .values = data, .count = count };
+	if (!str) {
+		return EMP_LEVEL_NO_STRING;
+	}
+	u32 offset = writer->string_size;
+	size_t length = SDL_strlen(str) + 1;
+	SDL_memcpy(writer->strings + offset, str, length);
+	writer->string_size += (u32)length;
+	return offset;
 }
 
-void emp_level_parse_int_grid_data(emp_level_asset_t* level, yyjson_val* layer, emp_value_grid_t* values)
+void emp_level_parse_int_grid_data(emp_level_writer_t* writer, yyjson_val* layer, emp_level_file_sublevel_t* sublevel)
 {
 	yyjson_val* int_grid = yyjson_obj_get(layer, "intGridCsv");
 
 	u64 idx;
 	u64 size = yyjson_arr_size(int_grid);
-	*values = emp_level_reserve_values(level, (u32)size);
+	u8* entries = writer->values + writer->value_count;
+	sublevel->value_first = writer->value_count;
+	sublevel->value_count = (u32)size;
+	writer->value_count += (u32)size;
 
 	yyjson_val* value;
 	yyjson_arr_foreach(int_grid, idx, size, value)
 	{
-		values->entries[idx] = (u8)yyjson_get_int(value);
+		entries[idx] = (u8)yyjson_get_int(value);
 	}
 }
 
-void emp_level_parse_tile_data(emp_level_asset_t* level, const char* name, yyjson_val* layer, emp_tiles_data_t* tiles)
+// `grid` is the sublevel whose value grid the tiles must fall on, or NULL
+// for decoration, which has none.
+void emp_level_parse_tile_data(emp_level_writer_t* writer, const char* name, yyjson_val* layer, const emp_level_file_sublevel_t* grid, u32* first, u32* count)
 {
 	yyjson_val* layer_tiles = yyjson_obj_get(layer, name);
 
 	u64 idx, size;
-	size = yyjson_arr_size(layer_tiles);
-	*tiles = emp_level_reserve_tiles(level, (u32)size);
+	*first = writer->tile_count;
 
 	yyjson_val* value;
 	yyjson_arr_foreach(layer_tiles, idx, size, value)
 	{
-		emp_tile_desc_t* tile_desc = tiles->values + idx;
 		yyjson_val* px = yyjson_obj_get(value, "px");
 		yyjson_val* src = yyjson_obj_get(value, "src");
+		u64 coords[4] = {
+			yyjson_get_uint(yyjson_arr_get(px, 0)),
+			yyjson_get_uint(yyjson_arr_get(px, 1)),
+			yyjson_get_uint(yyjson_arr_get(src, 0)),
+			yyjson_get_uint(yyjson_arr_get(src, 1)),
+		};
+		if (SDL_max(SDL_max(coords[0], coords[1]), SDL_max(coords[2], coords[3])) > SDL_MAX_UINT16) {
+			writer->skipped.out_of_range++;
+			continue;
+		}
 
-		tile_desc->dst.x = (float)yyjson_get_num(yyjson_arr_get(px, 0));
-		tile_desc->dst.y = (float)yyjson_get_num(yyjson_arr_get(px, 1));
-		tile_desc->src.x = (float)yyjson_get_num(yyjson_arr_get(src, 0));
-		tile_desc->src.y = (float)yyjson_get_num(yyjson_arr_get(src, 1));
+		emp_tile_desc_t* tile_desc = writer->tiles + writer->tile_count;
+		tile_desc->dst.x = (u16)coords[0];
+		tile_desc->dst.y = (u16)coords[1];
+		tile_desc->src.x = (u16)coords[2];
+		tile_desc->src.y = (u16)coords[3];
+		if (grid && !emp_level_tile_on_grid(tile_desc, grid->grid_size, grid->grid_width, grid->grid_height)) {
+			SDL_zerop(tile_desc);
+			writer->skipped.off_grid++;
+			continue;
+		}
+		writer->tile_count++;
 	}
+	*count = writer->tile_count - *first;
 }
 
-int emp_level_add_entities_from_fields(emp_level_asset_t* level, yyjson_val* fields, emp_level_entity_t* out_entity)
+int emp_level_add_entities_from_fields(yyjson_val* fields, emp_level_entity_t* out_entity)
 {
 	u64 idx, size;
 	yyjson_val* field;
@@ -163,46 +205,43 @@ int emp_level_add_entities_from_fields(emp_level_asset_t* level, yyjson_val* fie
 	return is_reasonably_constructed;
 }
 
-static void emp_level_entities_list_add(emp_level_entities_list_t* list, emp_level_entity_t* value)
+static void emp_level_entities_list_add(emp_level_writer_t* writer, emp_level_entity_t* value)
 {
-	if (list->count < SDL_arraysize(list->entries)) {
-		list->entries[list->count] = *value;
-		list->count = list->count + 1;
-	} else {
-		SDL_Log("No space in entity list anymore. Bump the capacity");
-	}
+	writer->entities[writer->header->entity_count] = *value;
+	writer->header->entity_count = writer->header->entity_count + 1;
 }
 
-static void emp_level_teleporter_list_add(emp_level_teleporter_list_t* set, emp_level_teleporter_t* value)
+static void emp_level_teleporter_list_add(emp_level_writer_t* writer, emp_level_teleporter_t* value)
 {
-	u32 slot = value->id % SDL_arraysize(set->entries);
+	u32 capacity = writer->header->teleporter_capacity;
+	u32 slot = value->id % capacity;
 	for (;;) {
-		emp_level_teleporter_t* teleporter = set->entries + slot;
+		emp_level_teleporter_t* teleporter = writer->teleporters + slot;
 		if (teleporter->id == 0) {
-			set->count = set->count + 1;
+			writer->header->teleporter_count = writer->header->teleporter_count + 1;
 			*teleporter = *value;
 			return;
 		}
-		slot = (slot + 1) % SDL_arraysize(set->entries);
+		slot = (slot + 1) % capacity;
 	}
 }
 
-u32 emp_level_teleporter_list_find(emp_level_teleporter_list_t* set, u64 id)
+u32 emp_level_teleporter_list_find(const emp_level_teleporter_list_t* set, u64 id)
 {
-	u32 slot = id % SDL_arraysize(set->entries);
+	u32 slot = id % set->capacity;
 	for (;;) {
-		emp_level_teleporter_t* teleporter = set->entries + slot;
+		const emp_level_teleporter_t* teleporter = set->entries + slot;
 		if (teleporter->id == 0) {
 			return 0;
 		}
 		if (teleporter->id == id) {
 			return slot + 1;
 		}
-		slot = (slot + 1) % SDL_arraysize(set->entries);
+		slot = (slot + 1) % set->capacity;
 	}
 }
 
-static void emp_level_add_entities(emp_level_asset_t* level, yyjson_val* instances)
+static void emp_level_add_entities(emp_level_writer_t* writer, yyjson_val* instances)
 {
 	u64 idx, size;
 	yyjson_val* instance;
@@ -242,7 +281,7 @@ static void emp_level_add_entities(emp_level_asset_t* level, yyjson_val* instanc
 				yyjson_val* eid = yyjson_obj_get(value, "entityIid");
 				tp.other = hash_str(yyjson_get_str(eid));
 				// THIS ONE IS NOT GETTING ADDED 
-				emp_level_teleporter_list_add(&level->teleporters, &tp);
+				emp_level_teleporter_list_add(writer, &tp);
 				continue;
 			}
 
@@ -253,16 +292,16 @@ static void emp_level_add_entities(emp_level_asset_t* level, yyjson_val* instanc
 		}
 
 		yyjson_val* fields = yyjson_obj_get(instance, "fieldInstances");
-		if (emp_level_add_entities_from_fields(level, fields, &entity)) {
+		if (emp_level_add_entities_from_fields(fields, &entity)) {
 			is_reasonably_constructed = 1;
 		}
 		if(is_reasonably_constructed) {
-			emp_level_entities_list_add(&level->entities, &entity);
+			emp_level_entities_list_add(writer, &entity);
 		}
 	}
 }
 
-void emp_load_sublevel(emp_level_asset_t* level, u32 index, yyjson_val* data)
+void emp_load_sublevel(emp_level_writer_t* writer, u32 index, yyjson_val* data)
 {
 	yyjson_val* layerInstances = yyjson_obj_get(data, "layerInstances");
 
@@ -270,9 +309,9 @@ void emp_load_sublevel(emp_level_asset_t* level, u32 index, yyjson_val* data)
 
 	yyjson_val* layer;
 
-	emp_tiles_data_t tiles = { 0 };
-	emp_value_grid_t values = { 0 };
-	emp_decoration_data_t decoration = { 0 };
+	emp_level_file_sublevel_t* sublevel = writer->sublevels + index;
+	sublevel->tilemap = EMP_LEVEL_NO_STRING;
+	sublevel->decoration_tilemap = EMP_LEVEL_NO_STRING;
 
 	yyjson_arr_foreach(layerInstances, idx, size, layer)
 	{
@@ -280,37 +319,93 @@ void emp_load_sublevel(emp_level_asset_t* level, u32 index, yyjson_val* data)
 		const char* str = yyjson_get_str(id);
 
 		if (SDL_strcmp(str, "world") == 0) {
-			emp_level_parse_int_grid_data(level, layer, &values);
-			emp_level_parse_tile_data(level, "autoLayerTiles", layer, &tiles);
-			tiles.tilemap = SDL_strdup(yyjson_get_str(yyjson_obj_get(layer, "__tilesetRelPath")));
-			values.grid_size = (float)yyjson_get_num(yyjson_obj_get(layer, "__gridSize"));
-			values.grid_width = (u32)yyjson_get_uint(yyjson_obj_get(layer, "__cWid"));
-			values.grid_height = (u32)yyjson_get_uint(yyjson_obj_get(layer, "__cHei"));
+			sublevel->grid_size = (float)yyjson_get_num(yyjson_obj_get(layer, "__gridSize"));
+			sublevel->grid_width = (u32)yyjson_get_uint(yyjson_obj_get(layer, "__cWid"));
+			sublevel->grid_height = (u32)yyjson_get_uint(yyjson_obj_get(layer, "__cHei"));
+			emp_level_parse_int_grid_data(writer, layer, sublevel);
+			emp_level_parse_tile_data(writer, "autoLayerTiles", layer, sublevel, &sublevel->tile_first, &sublevel->tile_count);
+			sublevel->tilemap = emp_level_add_string(writer, yyjson_get_str(yyjson_obj_get(layer, "__tilesetRelPath")));
 		}
 
 		if (SDL_strcmp(str, "entities") == 0) {
-			level->entities.grid_size = (float)yyjson_get_num(yyjson_obj_get(layer, "__gridSize"));
+			writer->header->entity_grid_size = (float)yyjson_get_num(yyjson_obj_get(layer, "__gridSize"));
 			yyjson_val* instances = yyjson_obj_get(layer, "entityInstances");
-			emp_level_add_entities(level, instances);
+			emp_level_add_entities(writer, instances);
 		}
 
 		if (SDL_strcmp(str, "decoration") == 0) {
-			decoration.grid_size = (float)yyjson_get_num(yyjson_obj_get(layer, "__gridSize"));
-			emp_level_parse_tile_data(level, "gridTiles", layer, &decoration.tiles);
-			decoration.tiles.tilemap = SDL_strdup(yyjson_get_str(yyjson_obj_get(layer, "__tilesetRelPath")));
+			sublevel->decoration_grid_size = (float)yyjson_get_num(yyjson_obj_get(layer, "__gridSize"));
+			emp_level_parse_tile_data(writer, "gridTiles", layer, NULL, &sublevel->decoration_first, &sublevel->decoration_count);
+			sublevel->decoration_tilemap = emp_level_add_string(writer, yyjson_get_str(yyjson_obj_get(layer, "__tilesetRelPath")));
+		}
+	}
+
+	sublevel->offset_x = (float)yyjson_get_num(yyjson_obj_get(data, "worldX"));
+	sublevel->offset_y = (float)yyjson_get_num(yyjson_obj_get(data, "worldY"));
+}
+
+// The first pass of the JSON loader: sizes every section so the second can
+// write the level into one allocation. Entities are only bounded, since an
+// instance's fields decide whether it becomes one.
+static emp_level_file_header_t emp_level_count(yyjson_val* sublevels)
+{
+	emp_level_file_header_t header = {
+		.magic = EMP_LEVEL_MAGIC,
+		.version = EMP_LEVEL_VERSION,
+		.sublevel_count = (u32)yyjson_arr_size(sublevels),
+	};
+	u32 teleporter_count = 0;
+
+	u64 idx, size;
+	yyjson_val* data;
+	yyjson_arr_foreach(sublevels, idx, size, data)
+	{
+		u64 layer_idx, layer_count;
+		yyjson_val* layer;
+		yyjson_arr_foreach(yyjson_obj_get(data, "layerInstances"), layer_idx, layer_count, layer)
+		{
+			const char* str = yyjson_get_str(yyjson_obj_get(layer, "__identifier"));
+			const char* tilemap = yyjson_get_str(yyjson_obj_get(layer, "__tilesetRelPath"));
+
+			if (SDL_strcmp(str, "world") == 0) {
+				header.value_count += (u32)yyjson_arr_size(yyjson_obj_get(layer, "intGridCsv"));
+				header.tile_count += (u32)yyjson_arr_size(yyjson_obj_get(layer, "autoLayerTiles"));
+				header.string_size += tilemap ? (u32)SDL_strlen(tilemap) + 1 : 0;
+			}
+
+			if (SDL_strcmp(str, "entities") == 0) {
+				u64 instance_idx, instance_count;
+				yyjson_val* instance;
+				yyjson_arr_foreach(yyjson_obj_get(layer, "entityInstances"), instance_idx, instance_count, instance)
+				{
+					const char* identifier = yyjson_get_str(yyjson_obj_get(instance, "__identifier"));
+					if (identifier && SDL_strcmp(identifier, "teleporter") == 0) {
+						teleporter_count++;
+					} else {
+						header.entity_count++;
+					}
+				}
+			}
+
+			if (SDL_strcmp(str, "decoration") == 0) {
+				header.tile_count += (u32)yyjson_arr_size(yyjson_obj_get(layer, "gridTiles"));
+				header.string_size += tilemap ? (u32)SDL_strlen(tilemap) + 1 : 0;
+			}
 		}
 	}
 
-	emp_sublevel_t* sublevel = emp_level_create_sublevel(level, &values, &tiles, &decoration);
-	// sublevel->id = SDL_strdup(yyjson_get_str(yyjson_obj_get(data, "iid")));
-	sublevel->offset.x = (float)yyjson_get_num(yyjson_obj_get(data, "worldX"));
-	sublevel->offset.y = (float)yyjson_get_num(yyjson_obj_get(data, "worldY"));
+	// At most half full, and never full, so lookups always reach an empty slot.
+	header.teleporter_capacity = 1;
+	while (header.teleporter_capacity <= teleporter_count * 2) {
+		header.teleporter_capacity *= 2;
+	}
+	return header;
 }
 
 u32 emp_level_query(emp_level_asset_t* level, emp_entity_type type, u32 offset)
 {
 	for (u32 index = offset; index < level->entities.count; index++) {
-		emp_level_entity_t* entity = level->entities.entries + index;
+		const emp_level_entity_t* entity = level->entities.entries + index;
 		if (entity->type == type) {
 			return index + 1;
 		}
@@ -318,43 +413,286 @@ u32 emp_level_query(emp_level_asset_t* level, emp_entity_type type, u32 offset)
 	return 0;
 }
 
-emp_level_entity_t* emp_level_get(emp_level_asset_t* level, u32 at)
+const emp_level_entity_t* emp_level_get(emp_level_asset_t* level, u32 at)
 {
 	return level->entities.entries + at;
 }
 
-void emp_load_level_asset(struct emp_asset_t* asset)
+// Sections of a compiled level, as byte offsets from its start.
+typedef struct emp_level_layout_t
 {
-	emp_buffer* buffer = &asset->data;
-	yyjson_doc* doc = yyjson_read((const char*)buffer->data, (size_t)buffer->size, 0);
+	u64 sublevels;
+	u64 teleporters;
+	u64 tiles;
+	u64 values;
+	u64 strings;
+	u64 entities;
+	u64 size;
+} emp_level_layout_t;
+
+static u64 emp_level_align(u64 offset)
+{
+	return (offset + 7) & ~(u64)7;
+}
 
-	yyjson_val* root = yyjson_doc_get_root(doc);
-	yyjson_val* sublevels = yyjson_obj_get(root, "levels");
+static emp_level_layout_t emp_level_layout(const emp_level_file_header_t* header)
+{
+	emp_level_layout_t layout;
+	layout.sublevels = emp_level_align(sizeof(emp_level_file_header_t));
+	layout.teleporters = emp_level_align(layout.sublevels + (u64)header->sublevel_count * sizeof(emp_level_file_sublevel_t));
+	layout.tiles = emp_level_align(layout.teleporters + (u64)header->teleporter_capacity * sizeof(emp_level_teleporter_t));
+	layout.values = emp_level_align(layout.tiles + (u64)header->tile_count * sizeof(emp_tile_desc_t));
+	layout.strings = emp_level_align(layout.values + header->value_count);
+	layout.entities = emp_level_align(layout.strings + header->string_size);
+	layout.size = layout.entities + (u64)header->entity_count * sizeof(emp_level_entity_t);
+	return layout;
+}
 
-	emp_level_asset_t* level = SDL_malloc(sizeof(*level));
-	SDL_memset(level, 0, sizeof(*level));
+// Writes the compiled form of the JSON `sublevels` into `data`, which holds
+// `header` sized by emp_level_count. Returns the compiled size, which is
+// smaller than the layout of `header` when some entities were left out.
+// Tiles that do not fit are left out and counted in `skipped`.
+static u64 emp_level_write(yyjson_val* sublevels, emp_level_file_header_t header, u8* data, emp_level_skipped_t* skipped)
+{
+	emp_level_layout_t layout = emp_level_layout(&header);
+	SDL_memset(data, 0, (size_t)layout.size);
+
+	emp_level_writer_t writer = {
+		.header = (emp_level_file_header_t*)data,
+		.sublevels = (emp_level_file_sublevel_t*)(data + layout.sublevels),
+		.teleporters = (emp_level_teleporter_t*)(data + layout.teleporters),
+		.tiles = (emp_tile_desc_t*)(data + layout.tiles),
+		.values = data + layout.values,
+		.strings = (char*)data + layout.strings,
+		.entities = (emp_level_entity_t*)(data + layout.entities),
+	};
+	*writer.header = header;
+	writer.header->entity_count = 0;
+	writer.header->teleporter_count = 0;
 
 	u64 idx, size;
 	yyjson_val* current;
 	yyjson_arr_foreach(sublevels, idx, size, current)
 	{
-		emp_load_sublevel(level, (u32)idx, current);
+		emp_load_sublevel(&writer, (u32)idx, current);
+	}
+	*skipped = writer.skipped;
+	return emp_level_layout(writer.header).size;
+}
+
+static bool emp_level_string(const emp_level_file_header_t* header, const char* strings, u32 offset, const char** out)
+{
+	if (offset == EMP_LEVEL_NO_STRING) {
+		*out = NULL;
+		return true;
+	}
+	*out = strings + offset;
+	return offset < header->string_size;
+}
+
+static bool emp_level_range(u32 first, u32 count, u32 total)
+{
+	return (u64)first + count <= total;
+}
+
+// Points `level` into the `size` bytes at `data` after checking that every
+// section, range and string fits, so a truncated or stale file fails here
+// and not mid-frame. `sublevels` has room for the level's sublevel count.
+static bool emp_level_load_compiled(emp_level_asset_t* level, const u8* data, u64 size, emp_sublevel_t* sublevels)
+{
+	const emp_level_file_header_t* header = (const emp_level_file_header_t*)data;
+	if (size < sizeof(*header)) {
+		return false;
+	}
+	emp_level_layout_t layout = emp_level_layout(header);
+	if (layout.size > size) {
+		return false;
 	}
+	const char* strings = (const char*)data + layout.strings;
+	if (header->string_size > 0 && strings[header->string_size - 1] != '\0') {
+		return false;
+	}
+
+	const emp_level_file_sublevel_t* files = (const emp_level_file_sublevel_t*)(data + layout.sublevels);
+	const emp_tile_desc_t* tiles = (const emp_tile_desc_t*)(data + layout.tiles);
+	const u8* values = data + layout.values;
+	for (u32 i = 0; i < header->sublevel_count; ++i) {
+		const emp_level_file_sublevel_t* file = &files[i];
+		emp_sublevel_t* sublevel = &sublevels[i];
+		if (!emp_level_range(file->value_first, file->value_count, header->value_count) ||
+			!emp_level_range(file->tile_first, file->tile_count, header->tile_count) ||
+			!emp_level_range(file->decoration_first, file->decoration_count, header->tile_count) ||
+			(u64)file->grid_width * file->grid_height > file->value_count ||
+			!emp_level_string(header, strings, file->tilemap, &sublevel->tiles.tilemap) ||
+			!emp_level_string(header, strings, file->decoration_tilemap, &sublevel->decoration.tiles.tilemap)) {
+			return false;
+		}
+
+		sublevel->offset = (emp_vec2_t) { file->offset_x, file->offset_y };
+		sublevel->values = (emp_value_grid_t) {
+			.grid_size = file->grid_size,
+			.grid_width = file->grid_width,
+			.grid_height = file->grid_height,
+			.entries = values + file->value_first,
+			.count = file->value_count,
+		};
+		sublevel->tiles.values = tiles + file->tile_first;
+		sublevel->tiles.count = file->tile_count;
+		sublevel->decoration.grid_size = file->decoration_grid_size;
+		sublevel->decoration.tiles.values = tiles + file->decoration_first;
+		sublevel->decoration.tiles.count = file->decoration_count;
+
+		for (u32 t = 0; t < sublevel->tiles.count; ++t) {
+			if (!emp_level_tile_on_grid(&sublevel->tiles.values[t], file->grid_size, file->grid_width, file->grid_height)) {
+				return false;
+			}
+		}
+	}
+
+	level->sublevels = (emp_sublevel_list_t) { .entries = sublevels, .count = header->sublevel_count };
+	level->entities = (emp_level_entities_list_t) {
+		.grid_size = header->entity_grid_size,
+		.entries = (const emp_level_entity_t*)(data + layout.entities),
+		.count = header->entity_count,
+	};
+	level->teleporters = (emp_level_teleporter_list_t) {
+		.entries = (const emp_level_teleporter_t*)(data + layout.teleporters),
+		.capacity = header->teleporter_capacity,
+		.count = header->teleporter_count,
+	};
+	return true;
+}
+
+// Whether `data` holds a whole compiled level that this build can read.
+static bool emp_level_check_header(const u8* data, u64 size)
+{
+	const emp_level_file_header_t* header = (const emp_level_file_header_t*)data;
+	return ((uintptr_t)data & 7) == 0 && size >= sizeof(*header) &&
+		header->version == EMP_LEVEL_VERSION && emp_level_layout(header).size <= size &&
+		header->teleporter_capacity > 0 && header->teleporter_count < header->teleporter_capacity;
+}
 
-	asset->handle = (emp_level_asset_t*)level;
+static bool emp_level_is_compiled(const u8* data, u64 size)
+{
+	u32 magic = 0;
+	if (size >= sizeof(magic)) {
+		SDL_memcpy(&magic, data, sizeof(magic));
+	}
+	return magic == EMP_LEVEL_MAGIC;
+}
 
+// Compiles the JSON into a single allocation holding the runtime sublevels
+// followed by the compiled level, then loads that like a compiled file.
+// Tiles that do not fit are dropped with a warning, so the level still loads
+// while it is being edited. Logs why when it returns false.
+static bool emp_level_load_json(emp_level_asset_t* level, const char* path, const void* json, size_t size)
+{
+	yyjson_read_err error;
+	yyjson_doc* doc = yyjson_read_opts((char*)json, size, 0, NULL, &error);
+	if (!doc) {
+		SDL_Log("'%s' is not valid JSON: %s at byte %llu", path, error.msg, (unsigned long long)error.pos);
+		return false;
+	}
+	yyjson_val* sublevels = yyjson_obj_get(yyjson_doc_get_root(doc), "levels");
+
+	emp_level_file_header_t header = emp_level_count(sublevels);
+	u64 sublevel_size = emp_level_align((u64)header.sublevel_count * sizeof(emp_sublevel_t));
+	u8* memory = SDL_malloc((size_t)(sublevel_size + emp_level_layout(&header).size));
+	if (!memory) {
+		SDL_Log("Failed to allocate '%s'", path);
+		yyjson_doc_free(doc);
+		return false;
+	}
+	emp_level_skipped_t skipped;
+	u64 compiled_size = emp_level_write(sublevels, header, memory + sublevel_size, &skipped);
 	yyjson_doc_free(doc);
+	if (skipped.out_of_range > 0) {
+		SDL_Log("'%s': left out %u tiles with coordinates past %d", path, skipped.out_of_range, SDL_MAX_UINT16);
+	}
+	if (skipped.off_grid > 0) {
+		SDL_Log("'%s': left out %u tiles outside of their sublevel's grid", path, skipped.off_grid);
+	}
+
+	SDL_memset(memory, 0, (size_t)sublevel_size);
+	level->memory = memory;
+	if (!emp_level_load_compiled(level, memory + sublevel_size, compiled_size, (emp_sublevel_t*)memory)) {
+		SDL_Log("'%s' has a sublevel whose int grid does not cover its size", path);
+		return false;
+	}
+	return true;
 }
 
-void emp_unload_level_asset(struct emp_asset_t* asset)
+void emp_load_level_asset(struct emp_asset_t* asset)
 {
-	emp_level_asset_t* level_asset = (emp_level_asset_t*)asset->handle;
-	for (u32 li = 0; li < level_asset->sublevels.count; li++) {
-		emp_sublevel_t* sublevel = level_asset->sublevels.entries + li;
-		SDL_free(sublevel->tiles.tilemap);
-		SDL_free(sublevel->decoration.tiles.tilemap);
+	emp_buffer* buffer = &asset->data;
+	emp_level_asset_t* level = SDL_calloc(1, sizeof(*level));
+
+	if (!emp_level_is_compiled(buffer->data, buffer->size)) {
+		if (!emp_level_load_json(level, asset->path, buffer->data, (size_t)buffer->size)) {
+			SDL_free(level->memory);
+			SDL_zerop(level);
+		}
+	} else {
+		const emp_level_file_header_t* header = (const emp_level_file_header_t*)buffer->data;
+		bool valid = emp_level_check_header(buffer->data, buffer->size);
+		if (valid) {
+			level->memory = SDL_calloc(header->sublevel_count ? header->sublevel_count : 1, sizeof(emp_sublevel_t));
+			valid = emp_level_load_compiled(level, buffer->data, buffer->size, level->memory);
+		}
+		if (!valid) {
+			SDL_Log("'%s' is not a valid version %d level, rerun Florence", asset->path, EMP_LEVEL_VERSION);
+			SDL_free(level->memory);
+			SDL_zerop(level);
+		}
 	}
 
-	SDL_free(asset->handle);
+	asset->handle = level;
+}
+
+void emp_unload_level_asset(struct emp_asset_t* asset)
+{
+	emp_level_asset_t* level = (emp_level_asset_t*)asset->handle;
+	SDL_free(level->memory);
+	SDL_free(level);
 	asset->handle = NULL;
 }
+
+emp_buffer emp_level_compile(const void* json, size_t size)
+{
+	yyjson_doc* doc = yyjson_read((const char*)json, size, 0);
+	if (!doc) {
+		return (emp_buffer) { 0 };
+	}
+	yyjson_val* sublevels = yyjson_obj_get(yyjson_doc_get_root(doc), "levels");
+
+	emp_level_file_header_t header = emp_level_count(sublevels);
+	u8* data = SDL_malloc((size_t)emp_level_layout(&header).size);
+	if (!data) {
+		yyjson_doc_free(doc);
+		return (emp_buffer) { 0 };
+	}
+	emp_level_skipped_t skipped;
+	u64 compiled_size = emp_level_write(sublevels, header, data, &skipped);
+	yyjson_doc_free(doc);
+	// A shipped level keeps every tile, so one that does not fit fails the build.
+	if (skipped.out_of_range > 0 || skipped.off_grid > 0) {
+		SDL_Log("Level has %u tiles with coordinates past %d and %u tiles outside of their sublevel's grid",
+			skipped.out_of_range, SDL_MAX_UINT16, skipped.off_grid);
+		SDL_free(data);
+		return (emp_buffer) { 0 };
+	}
+
+	// Run the loader's checks now, since rerunning Florence cannot fix a level
+	// the game rejects.
+	emp_level_asset_t level = { 0 };
+	emp_sublevel_t* scratch = SDL_calloc(header.sublevel_count ? header.sublevel_count : 1, sizeof(emp_sublevel_t));
+	bool valid = scratch && emp_level_check_header(data, compiled_size) &&
+		emp_level_load_compiled(&level, data, compiled_size, scratch);
+	SDL_free(scratch);
+	if (!valid) {
+		SDL_Log("Compiled level fails the loader's checks; is a sublevel's int grid smaller than its size?");
+		SDL_free(data);
+		return (emp_buffer) { 0 };
+	}
+	return (emp_buffer) { .size = compiled_size, .data = data };
+}
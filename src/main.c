@@ -21,7 +21,10 @@
 #define WINDOW_HEIGHT 1080
 
 #include "entities.h"
+#include "replay.h"
+#include "snapshot.h"
 
+#include <Empire/atlas.h>
 #include <Empire/generated/assets_generated.h>
 #include <Empire/level.h>
 #include <Empire/stb_image.h>
@@ -35,11 +38,31 @@ typedef struct
 
 static SDL_Window* g_window = NULL;
 static SDL_Renderer* g_renderer = NULL;
+static emp_atlas_t g_atlas;
 static emp_generated_assets_o* g_assets = NULL;
 static emp_asset_manager_o* g_asset_mgr = NULL;
 static Uint64 g_last_time = 0;
+static double g_accumulator = 0.0;
 static bool g_running = true;
 static ma_engine g_audio_engine;
+static ma_context g_audio_context;
+static bool g_audio_context_initialized = false;
+static emp_replay_t g_replay;
+static emp_rewind_t* g_rewind = NULL;
+static u32 g_rewind_steps = 0;
+
+// The simulation always advances in whole steps of EMP_STEP_DT, however
+// long frames take, so windowed, headless and replayed runs step the same.
+#define EMP_STEP_HZ 120
+#define EMP_STEP_DT (1.0 / EMP_STEP_HZ)
+// Frame time beyond this is dropped instead of caught up on, so a stall
+// slows the game down rather than spiralling into ever longer frames.
+#define EMP_MAX_FRAME_TIME 0.25
+// Rewind snapshots are taken every 12 steps (100 ms); one in 16 is a full
+// keyframe. Holding R restores and drops one snapshot per step, so it
+// rewinds 120 snapshots (12 s of play) per second held at any frame rate.
+#define EMP_REWIND_INTERVAL 12
+#define EMP_REWIND_KEYFRAME_INTERVAL 16
 
 void update_sprite_magnification(void)
 {
@@ -55,6 +78,86 @@ void update_sprite_magnification(void)
 	SPRITE_MAGNIFICATION = (float)snapped;
 }
 
+static void sample_input(emp_input_t* input)
+{
+	static const SDL_Scancode scancodes[emp_key_count] = {
+		[emp_key_up] = SDL_SCANCODE_W,
+		[emp_key_left] = SDL_SCANCODE_A,
+		[emp_key_down] = SDL_SCANCODE_S,
+		[emp_key_right] = SDL_SCANCODE_D,
+		[emp_key_fire] = SDL_SCANCODE_SPACE,
+		[emp_key_kill] = SDL_SCANCODE_M,
+		[emp_key_reload_level] = SDL_SCANCODE_K,
+		[emp_key_rewind] = SDL_SCANCODE_R,
+		[emp_key_weapon_1 + 0] = SDL_SCANCODE_1,
+		[emp_key_weapon_1 + 1] = SDL_SCANCODE_2,
+		[emp_key_weapon_1 + 2] = SDL_SCANCODE_3,
+		[emp_key_weapon_1 + 3] = SDL_SCANCODE_4,
+		[emp_key_weapon_1 + 4] = SDL_SCANCODE_5,
+		[emp_key_weapon_1 + 5] = SDL_SCANCODE_6,
+		[emp_key_weapon_1 + 6] = SDL_SCANCODE_7,
+		[emp_key_weapon_1 + 7] = SDL_SCANCODE_8,
+	};
+
+	const bool* state = SDL_GetKeyboardState(NULL);
+	input->keys = 0;
+	for (u32 key = 0; key < emp_key_count; ++key) {
+		if (state[scancodes[key]]) {
+			input->keys |= 1u << key;
+		}
+	}
+	input->buttons = SDL_GetMouseState(&input->mouse.x, &input->mouse.y);
+}
+
+// Fills G->input for the frame, from the replay being played back or from
+// SDL (recording it if a log is open). Returns false once a replay runs out.
+static bool advance_input(double* dt)
+{
+	if (g_replay.playing) {
+		emp_replay_frame_t frame;
+		if (!emp_replay_read(&g_replay, &frame)) {
+			SDL_Log("Replay finished after %llu frames", (unsigned long long)g_replay.frames);
+			g_running = false;
+			return false;
+		}
+		*dt = frame.dt;
+		G->input = frame.input;
+		G->view_size = frame.view_size;
+		SPRITE_MAGNIFICATION = frame.magnification;
+		return true;
+	}
+
+	sample_input(&G->input);
+	if (g_replay.io) {
+		emp_replay_frame_t frame = {
+			.dt = *dt,
+			.input = G->input,
+			.view_size = G->view_size,
+			.magnification = SPRITE_MAGNIFICATION,
+		};
+		if (!emp_replay_write(&g_replay, &frame)) {
+			SDL_Log("Failed to write replay, recording stopped after %llu frames: %s", (unsigned long long)g_replay.frames, SDL_GetError());
+			emp_replay_end(&g_replay);
+		}
+	}
+	return true;
+}
+
+static void simulate_frame(double dt)
+{
+	if (g_rewind) {
+		if (++g_rewind_steps >= EMP_REWIND_INTERVAL) {
+			g_rewind_steps = 0;
+			emp_rewind_record(g_rewind);
+		}
+		if (emp_input_down(&G->input, emp_key_rewind) && emp_rewind_restore_latest(g_rewind)) {
+			emp_rewind_pop(g_rewind);
+		}
+	}
+
+	emp_simulate(dt);
+}
+
 void main_loop(void)
 {
 	SDL_Event event;
@@ -68,79 +171,113 @@ void main_loop(void)
 		if (event.type == SDL_EVENT_WINDOW_RESIZED) {
 			update_sprite_magnification();
 		}
+		// Lost targets keep their textures but not their contents; a lost
+		// device takes the textures with it.
+		if (event.type == SDL_EVENT_RENDER_TARGETS_RESET && G->level) {
+			emp_level_invalidate_chunks();
+		}
+		if (event.type == SDL_EVENT_RENDER_DEVICE_RESET && G->level) {
+			emp_level_release_chunks();
+		}
 
 	}
+	emp_asset_manager_finish_loads(g_asset_mgr);
 
-	Uint64 current_time = SDL_GetTicks();
-	double delta_time = (current_time - g_last_time) / 1000.0;
-	delta_time = SDL_min(delta_time, 0.5f);
+	Uint64 current_time = SDL_GetTicksNS();
+	double frame_time = (double)(current_time - g_last_time) / 1e9;
 	g_last_time = current_time;
-	G->args->dt = (float)delta_time;
-	G->args->global_time += delta_time;
+	g_accumulator += SDL_min(frame_time, EMP_MAX_FRAME_TIME);
+
+	int win_w, win_h;
+	SDL_GetWindowSize(g_window, &win_w, &win_h);
+	G->view_size = (emp_vec2_t) { .x = (float)win_w, .y = (float)win_h };
+
+	while (g_accumulator >= EMP_STEP_DT) {
+		double dt = EMP_STEP_DT;
+		if (!advance_input(&dt)) {
+			return;
+		}
+		simulate_frame(dt);
+		g_accumulator -= EMP_STEP_DT;
+	}
+	emp_sound_flush();
+	emp_music_player_update(G->music_player);
 
 	SDL_SetRenderDrawColor(g_renderer, 17, 25, 45, 1);
 	SDL_RenderClear(g_renderer);
 
-	emp_entities_update();
+	emp_render((float)(g_accumulator / EMP_STEP_DT));
 
-	int win_w, win_h;
-	SDL_GetWindowSize(g_window, &win_w, &win_h);
-
-	char buffer2[64];
-	SDL_snprintf(buffer2, sizeof(buffer2), "Under the C");
-	emp_draw_text((float)win_w / 2 - 200, 100, buffer2, 187, 195, 208, &g_assets->ttf->asepritefont);
+	emp_draw_text((float)win_w / 2 - 200, 100, "Under the C", 187, 195, 208, &g_assets->ttf->asepritefont, emp_layer_ui);
 
+	emp_sprite_batch_flush(G->sprites, g_renderer);
 	SDL_RenderPresent(g_renderer);
 }
 
-int parse_atlas_width_from_path_name(const char* path)
+void emp_png_load_func(emp_asset_t* asset)
 {
-	const char* dot = SDL_strrchr(path, '.');
-	const char* underscore = SDL_strrchr(path, '_');
-	if (underscore && (!dot || underscore < dot)) {
-		return SDL_atoi(underscore + 1);
+	const emp_atlas_region_t* region = asset->meta;
+	emp_texture_t* emp_tex = SDL_malloc(sizeof(emp_texture_t));
+	SDL_zerop(emp_tex);
+	asset->handle = emp_tex;
+	if (!region) {
+		SDL_Log("'%s' has no atlas region, rerun Florence", asset->path);
+		return;
+	}
+	emp_texture_from_region(emp_tex, region);
+
+	// Headless: the simulation only needs sprite sizes, which the region has.
+	if (g_renderer) {
+		int width, height, channels;
+		unsigned char* data = stbi_load_from_memory(asset->data.data, (int)asset->data.size, &width, &height, &channels, 4);
+		if (data && (u32)width == region->width && (u32)height == region->height) {
+			emp_tex->surface = SDL_CreateSurfaceFrom(width, height, SDL_PIXELFORMAT_RGBA32, data, width * 4);
+		} else {
+			SDL_Log("'%s' does not match its %ux%u atlas region, rerun Florence", asset->path, region->width, region->height);
+			stbi_image_free(data);
+		}
 	}
-	return 0;
 }
 
-void emp_png_load_func(emp_asset_t* asset)
+void emp_png_finish_func(emp_asset_t* asset)
 {
-	int width, height, channels;
-	unsigned char* data = stbi_load_from_memory(asset->data.data, (int)asset->data.size, &width, &height, &channels, 4);
-
-	SDL_Surface* surface = SDL_CreateSurfaceFrom(
-		width, height, SDL_PIXELFORMAT_RGBA32, data, width * 4);
-
-	SDL_Texture* texture = SDL_CreateTextureFromSurface(g_renderer, surface);
-	SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
-	SDL_DestroySurface(surface);
-	stbi_image_free(data);
-	emp_texture_t* emp_tex = SDL_malloc(sizeof(emp_texture_t));
-
-	emp_tex->texture = texture;
-
-	int atlas_size = parse_atlas_width_from_path_name(asset->path);
-	if (atlas_size) {
-		emp_tex->source_size = (u32)(atlas_size);
-		emp_tex->columns = width / atlas_size;
-		emp_tex->rows = height / atlas_size;
-		emp_tex->width = (float)atlas_size;
-		emp_tex->height = (float)atlas_size;
-	} else {
-		emp_tex->source_size = width;
-		emp_tex->rows = 1;
-		emp_tex->columns = 1;
-		emp_tex->width = (float)width;
-		emp_tex->height = (float)height;
+	emp_texture_t* emp_tex = asset->handle;
+	if (!asset->meta || !g_renderer) {
+		return;
+	}
+	SDL_Surface* surface = emp_tex->surface;
+	emp_atlas_place(&g_atlas, emp_tex, asset->meta, surface ? surface->pixels : NULL);
+	if (surface) {
+		void* pixels = surface->pixels;
+		SDL_DestroySurface(surface);
+		stbi_image_free(pixels);
+		emp_tex->surface = NULL;
 	}
+	// A reloaded tileset has to be baked into the level chunks again.
+	if (G->level) {
+		emp_level_invalidate_chunks();
+	}
+}
 
-	asset->handle = emp_tex;
+// On hot reload the level is rebuilt like a manual reload, so collision,
+// tile health and the chunk lists match the new data.
+void emp_ldtk_finish_func(emp_asset_t* asset)
+{
+	if (G->level && asset == &G->assets->ldtk->world) {
+		emp_create_level(asset, 1);
+	}
 }
 
 void emp_png_unload_func(emp_asset_t* asset)
 {
 	emp_texture_t* emp_tex = asset->handle;
-	SDL_DestroyTexture(emp_tex->texture);
+	if (asset->meta) {
+		emp_atlas_release(&g_atlas, emp_tex, asset->meta);
+	}
+	if (emp_tex->surface) {
+		stbi_image_free(emp_tex->surface->pixels);
+		SDL_DestroySurface(emp_tex->surface);
+	}
 	SDL_free(emp_tex);
 }
 
@@ -158,20 +295,109 @@ const char* get_asset_argument(int argc, char* arguments[])
 	return "";
 }
 
-typedef struct emp_audio_t {
-	ma_decoder decoder;
-	const void* data;
-	size_t size;
-} emp_audio_t;
+bool has_argument(int argc, char* arguments[], const char* flag)
+{
+	for (int index = 1; index < argc; index++) {
+		if (SDL_strcmp(arguments[index], flag) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* get_string_argument(int argc, char* arguments[], const char* token)
+{
+	u64 token_len = SDL_strlen(token);
+	for (int index = 1; index < argc; index++) {
+		if (SDL_strncmp(arguments[index], token, token_len) == 0) {
+			return arguments[index] + token_len;
+		}
+	}
+	return NULL;
+}
+
+u64 get_u64_argument(int argc, char* arguments[], const char* token, u64 fallback)
+{
+	u64 token_len = SDL_strlen(token);
+	for (int index = 1; index < argc; index++) {
+		if (SDL_strncmp(arguments[index], token, token_len) == 0) {
+			return SDL_strtoull(arguments[index] + token_len, NULL, 10);
+		}
+	}
+	return fallback;
+}
+
+// Runs the simulation step after step as fast as possible, with no window,
+// renderer or audio device. Stops after `frame_limit` steps (0 = until quit).
+// When a replay is playing its recorded steps and input are used instead,
+// and the run ends with the log.
+int run_headless(u64 frame_limit)
+{
+	G->view_size = (emp_vec2_t) { .x = WINDOW_WIDTH, .y = WINDOW_HEIGHT };
+
+	u64 frames = 0;
+	double simulated = 0.0;
+	u64 start = SDL_GetTicksNS();
+	while (g_running && (frame_limit == 0 || frames < frame_limit)) {
+		SDL_Event event;
+		while (SDL_PollEvent(&event)) {
+			if (event.type == SDL_EVENT_QUIT) {
+				g_running = false;
+			}
+		}
+
+		emp_asset_manager_finish_loads(g_asset_mgr);
+
+		double dt = EMP_STEP_DT;
+		if (!advance_input(&dt)) {
+			break;
+		}
+		simulate_frame(dt);
+		emp_sound_flush();
+		emp_music_player_update(G->music_player);
+		simulated += dt;
+		frames++;
+	}
+	double elapsed = (double)(SDL_GetTicksNS() - start) / 1e9;
+
+	SDL_Log("Headless: %llu frames, %.1f s simulated in %.3f s, %.0f simulated frames per second",
+		(unsigned long long)frames, simulated, elapsed, elapsed > 0.0 ? (double)frames / elapsed : 0.0);
+
+	emp_replay_end(&g_replay);
+	if (g_rewind) {
+		emp_rewind_destroy(g_rewind);
+	}
+
+	emp_music_player_destroy();
+	emp_destroy_level();
+	emp_asset_manager_destroy(g_asset_mgr);
+	ma_engine_uninit(&g_audio_engine);
+	if (g_audio_context_initialized) {
+		ma_context_uninit(&g_audio_context);
+	}
+	// Sounds may still point into the package until the mixer has stopped.
+	emp_generated_assets_destroy(g_assets);
+	SDL_Quit();
+	return 0;
+}
 
 void emp_load_ogg_asset(struct emp_asset_t* asset)
 {
-	emp_audio_t* audio = SDL_malloc(sizeof(emp_audio_t));
+	emp_audio_t* audio = SDL_calloc(1, sizeof(emp_audio_t));
 	audio->data = asset->data.data;
 	audio->size = asset->data.size;
-	
-	ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 2, g_audio_engine.sampleRate);
-	ma_result result = ma_decoder_init_memory(audio->data, audio->size, &config, &audio->decoder);
+
+	// Music is minutes long and only ever has one voice, so it is streamed
+	// from the file (or package) as it plays; effects are short and replayed
+	// constantly.
+	if (SDL_strstr(asset->path, "_music_loopable")) {
+		asset->handle = audio;
+		return;
+	}
+	ma_decoder_config config = ma_decoder_config_init(ma_format_f32, EMP_AUDIO_CHANNELS, g_audio_engine.sampleRate);
+	void* pcm = NULL;
+	ma_result result = ma_decode_memory(audio->data, audio->size, &config, &audio->frame_count, &pcm);
+	audio->pcm = pcm;
 	if (result != MA_SUCCESS) {
 		SDL_Log("Failed to load OGG asset '%s': miniaudio error %d", asset->path, result);
 		SDL_free(audio);
@@ -184,7 +410,8 @@ void emp_unload_ogg_asset(struct emp_asset_t* asset)
 {
 	emp_audio_t* audio = asset->handle;
 	if (audio) {
-		ma_decoder_uninit(&audio->decoder);
+		emp_stop_voices(audio);
+		ma_free(audio->pcm, NULL);
 		SDL_free(audio);
 	}
 }
@@ -202,108 +429,46 @@ EM_BOOL on_canv_resize(int eventType, const EmscriptenUiEvent* uiEvent, void* us
 }
 #endif
 
-emp_compressed_buffer write_game_snapshot()
+int main(int argc, char* argv[])
 {
-	u64 args_size = sizeof(emp_update_args_t);
-	u64 player_size = sizeof(emp_player_t) * EMP_MAX_PLAYERS;
-	u64 enemy_size = sizeof(emp_enemy_t) * EMP_MAX_ENEMIES;
-	u64 spawner_size = sizeof(emp_spawner_t) * EMP_MAX_SPAWNERS;
-	u64 bullet_size = sizeof(emp_bullet_t) * EMP_MAX_BULLETS;
-	u64 tile_health_size = sizeof(emp_tile_health_t) * EMP_LEVEL_TILES;
-
-	u64 total_size = 0;
+	bool headless = has_argument(argc, argv, "--headless");
 
-	total_size += args_size;
-	total_size += player_size;
-	total_size += enemy_size;
-	total_size += spawner_size;
-	total_size += bullet_size;
-	total_size += tile_health_size;
-
-	static emp_buffer scratch_buffer;
-	if (scratch_buffer.size != total_size)
-	{
-		scratch_buffer.data =SDL_realloc(scratch_buffer.data, total_size);
-		scratch_buffer.size = total_size;
+	if (!SDL_Init(headless ? SDL_INIT_EVENTS : SDL_INIT_VIDEO | SDL_INIT_AUDIO)) {
+		SDL_Log("Failed to initialize SDL: %s", SDL_GetError());
+		return 1;
 	}
 
-	u64 write_pos = 0;
-
-	SDL_memcpy(scratch_buffer.data + write_pos, G->args, args_size);
-	write_pos += args_size;
-	
-	SDL_memcpy(scratch_buffer.data + write_pos, G->player, player_size);
-	write_pos += player_size;
-
-	SDL_memcpy(scratch_buffer.data + write_pos, G->enemies, enemy_size);
-	write_pos += enemy_size;
-
-	SDL_memcpy(scratch_buffer.data + write_pos, G->spawners, spawner_size);
-	write_pos += spawner_size;
-
-	SDL_memcpy(scratch_buffer.data + write_pos, G->bullets, bullet_size);
-	write_pos += bullet_size;
-
-	SDL_memcpy(scratch_buffer.data + write_pos, G->level->health, tile_health_size);
-
-
-	return emp_compress_buffer(scratch_buffer);
-}
-
-void restore_game_snapshot(emp_compressed_buffer compressed_buffer)
-{
-	emp_buffer state_buffer = emp_decompress_buffer(compressed_buffer);
-
-	u64 args_size = sizeof(emp_update_args_t);
-	u64 player_size = sizeof(emp_player_t) * EMP_MAX_PLAYERS;
-	u64 enemy_size = sizeof(emp_enemy_t) * EMP_MAX_ENEMIES;
-	u64 spawner_size = sizeof(emp_spawner_t) * EMP_MAX_SPAWNERS;
-	u64 bullet_size = sizeof(emp_bullet_t) * EMP_MAX_BULLETS;
-	u64 tile_health_size = sizeof(emp_tile_health_t) * EMP_LEVEL_TILES;
-
-	u64 read_pos = 0;
-
-	SDL_memcpy(G->args, state_buffer.data + read_pos, args_size);
-	read_pos += args_size;
-
-	SDL_memcpy(G->player, state_buffer.data + read_pos, player_size);
-	read_pos += player_size;
-
-	SDL_memcpy(G->enemies , state_buffer.data+ read_pos, enemy_size);
-	read_pos += enemy_size;
-
-	SDL_memcpy(G->spawners , state_buffer.data+ read_pos, spawner_size);
-	read_pos += spawner_size;
-
-	SDL_memcpy(G->bullets , state_buffer.data+ read_pos, bullet_size);
-	read_pos += bullet_size;
-
-	SDL_memcpy(G->level->health , state_buffer.data+ read_pos, tile_health_size);
-	read_pos += tile_health_size;
-
-	emp_free_buffer(&state_buffer);
-}
-
-int main(int argc, char* argv[])
-{
-	if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO)) {
-		SDL_Log("Failed to initialize SDL: %s", SDL_GetError());
+	// A replay brings its own seed; a recording stores the one it starts from.
+	// Either one that can't be opened ends the run before anything loads.
+	u32 seed = (u32)get_u64_argument(argc, argv, "seed=", 0);
+	const char* replay_path = get_string_argument(argc, argv, "replay=");
+	const char* record_path = get_string_argument(argc, argv, "record=");
+	if (replay_path) {
+		if (!emp_replay_begin_playback(&g_replay, replay_path)) {
+			SDL_Quit();
+			return 1;
+		}
+		seed = g_replay.seed;
+	} else if (record_path && !emp_replay_begin_record(&g_replay, record_path, seed)) {
+		SDL_Quit();
 		return 1;
 	}
 
-	SDL_DisplayID display = SDL_GetPrimaryDisplay();
-	const SDL_DisplayMode* mode = SDL_GetCurrentDisplayMode(display);
-	int win_w = (int)(mode->w * 0.8f);
-	int win_h = (int)(mode->h * 0.8f);
-	SDL_CreateWindowAndRenderer("Empire", win_w, win_h, SDL_WINDOW_RESIZABLE, &g_window, &g_renderer);
-	SDL_SetWindowPosition(g_window, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED);
+	if (!headless) {
+		SDL_DisplayID display = SDL_GetPrimaryDisplay();
+		const SDL_DisplayMode* mode = SDL_GetCurrentDisplayMode(display);
+		int win_w = (int)(mode->w * 0.8f);
+		int win_h = (int)(mode->h * 0.8f);
+		SDL_CreateWindowAndRenderer("Empire", win_w, win_h, SDL_WINDOW_RESIZABLE, &g_window, &g_renderer);
+		SDL_SetWindowPosition(g_window, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED);
 
-	SDL_SetRenderVSync(g_renderer, 1);
+		SDL_SetRenderVSync(g_renderer, 1);
 
-	if (!g_window) {
-		SDL_Log("Failed to create window: %s", SDL_GetError());
-		SDL_Quit();
-		return 1;
+		if (!g_window) {
+			SDL_Log("Failed to create window: %s", SDL_GetError());
+			SDL_Quit();
+			return 1;
+		}
 	}
 
 	const char* root = get_asset_argument(argc, argv);
@@ -314,11 +479,13 @@ int main(int argc, char* argv[])
 	emp_asset_loader_t png_loader = {
 		.load = &emp_png_load_func,
 		.unload = &emp_png_unload_func,
+		.finish = &emp_png_finish_func,
 	};
 
 	emp_asset_loader_t ldtk_loader = {
 		.load = &emp_load_level_asset,
 		.unload = &emp_unload_level_asset,
+		.finish = &emp_ldtk_finish_func,
 	};
 
 	emp_asset_loader_t ogg_loader = {
@@ -326,21 +493,39 @@ int main(int argc, char* argv[])
 		.unload = &emp_unload_ogg_asset,
 	};
 
-	G = SDL_malloc(sizeof(emp_G));
+	// Zeroed so loader callbacks can tell that there is no level yet.
+	G = SDL_calloc(1, sizeof(emp_G));
 	
-	ma_result result = ma_engine_init(NULL, &g_audio_engine);
+	ma_engine_config engine_config = ma_engine_config_init();
+	if (headless) {
+		// The null backend mixes on its own thread without a real device.
+		ma_backend null_backend = ma_backend_null;
+		if (ma_context_init(&null_backend, 1, NULL, &g_audio_context) == MA_SUCCESS) {
+			engine_config.pContext = &g_audio_context;
+			g_audio_context_initialized = true;
+		}
+	}
+	ma_result result = ma_engine_init(&engine_config, &g_audio_engine);
 	if (result != MA_SUCCESS) {
 		SDL_Log("Failed to initialize miniaudio engine: %d", result);
 	}
 	G->mixer = &g_audio_engine;
 
-	emp_load_font(g_renderer, &g_assets->ttf->bauhs93, 84.0f);
-	emp_load_font(g_renderer, &g_assets->ttf->asepritefont, 84.0f);
+	if (!headless) {
+		emp_load_font(g_renderer, &g_assets->ttf->bauhs93, 84.0f);
+		emp_load_font(g_renderer, &g_assets->ttf->asepritefont, 84.0f);
+	}
 	emp_asset_manager_add_loader(g_asset_mgr, png_loader, EMP_ASSET_TYPE_PNG);
 	emp_asset_manager_add_loader(g_asset_mgr, ldtk_loader, EMP_ASSET_TYPE_LDTK);
 	emp_asset_manager_add_loader(g_asset_mgr, ogg_loader, EMP_ASSET_TYPE_OGG);
 
-	emp_asset_manager_check_hot_reload(g_asset_mgr, 10.0f);
+	emp_atlas_init(&g_atlas, g_renderer, emp_atlas_pages, EMP_ATLAS_PAGE_COUNT);
+
+	// The level and sprites are needed for the first frame; sounds finish
+	// loading while the game runs and are skipped until they have.
+	emp_asset_manager_load_async(g_asset_mgr);
+	emp_asset_manager_wait_type(g_asset_mgr, EMP_ASSET_TYPE_PNG);
+	emp_asset_manager_wait_type(g_asset_mgr, EMP_ASSET_TYPE_LDTK);
 
 	G->assets = g_assets;
 	G->args = SDL_malloc(sizeof(emp_update_args_t));
@@ -350,25 +535,36 @@ int main(int argc, char* argv[])
 	emp_init_enemy_configs();
 	emp_init_weapon_configs();
 
+	emp_seed_rng(seed);
+
 	emp_create_level(&G->assets->ldtk->world, 0);
 
 	emp_music_player_init();
 
-	update_sprite_magnification();
-
 	SDL_zerop(G->args);
-	g_last_time = SDL_GetTicks();
+
+#ifndef __EMSCRIPTEN__
+	static emp_rewind_t rewind;
+	emp_rewind_init(&rewind, 1024, EMP_REWIND_KEYFRAME_INTERVAL);
+	g_rewind = &rewind;
+#endif
+
+	if (headless) {
+		return run_headless(get_u64_argument(argc, argv, "frames=", 0));
+	}
+
+	update_sprite_magnification();
+	g_last_time = SDL_GetTicksNS();
 
 #ifdef __EMSCRIPTEN__
 	emscripten_set_resize_callback(EMSCRIPTEN_EVENT_TARGET_WINDOW, NULL, EM_FALSE, on_canv_resize);
 	emscripten_set_main_loop(main_loop, 0, 1);
 #else
+	emp_asset_manager_watch(g_asset_mgr);
+
 	u64 last_time = SDL_GetTicks() - 900;
 	u64 frame_count = 0;
 
-	u32 prev_state_write = 0;
-	emp_compressed_buffer* prvious_states = SDL_calloc(1024, sizeof(emp_compressed_buffer));
-
 	while (g_running) {
 		frame_count++;
 		u64 currentTime = SDL_GetTicks();
@@ -378,30 +574,23 @@ int main(int argc, char* argv[])
 			SDL_SetWindowTitle(g_window, title);
 			frame_count = 0;
 			last_time = currentTime;
-
-			emp_compressed_buffer* next = &prvious_states[prev_state_write];
-			if(next->data) { 
-				SDL_free(next->data);
-				next->data = NULL;
-			}
-			*next = write_game_snapshot();
-			prev_state_write = prev_state_write + 1 & (1024 - 1);
-		}
-
-		const bool* keys = SDL_GetKeyboardState(NULL);
-		if (keys[SDL_SCANCODE_R])
-		{
-			u32 slot = (prev_state_write - 1) & (1024 - 1);
-			if (prvious_states[slot].original_size > 0)
-			{
-				restore_game_snapshot(prvious_states[slot]);
-				prev_state_write = slot;
-			}
 		}
 
 		main_loop();
-		emp_asset_manager_check_hot_reload(g_asset_mgr, G->args->dt);
+		emp_asset_manager_check_hot_reload(g_asset_mgr);
+	}
+	emp_replay_end(&g_replay);
+	emp_rewind_destroy(g_rewind);
+	emp_music_player_destroy();
+	emp_destroy_level();
+	emp_asset_manager_destroy(g_asset_mgr);
+	emp_atlas_destroy(&g_atlas);
+	ma_engine_uninit(&g_audio_engine);
+	if (g_audio_context_initialized) {
+		ma_context_uninit(&g_audio_context);
 	}
+	// Sounds may still point into the package until the mixer has stopped.
+	emp_generated_assets_destroy(g_assets);
 #endif
 	SDL_DestroyWindow(g_window);
 	SDL_Quit();
@@ -0,0 +1,153 @@
+#include <Empire/assets.h>
+#include <Empire/lz4.h>
+#include <Empire/package.h>
+#include <SDL3/SDL.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static bool map_file(emp_package_t* package, const char* path)
+{
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size;
+	HANDLE mapping = NULL;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	}
+	const void* base = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (!base) {
+		if (mapping) {
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		return false;
+	}
+	package->file = file;
+	package->mapping = mapping;
+	package->base = base;
+	package->size = (u64)size.QuadPart;
+	return true;
+#elif defined(__EMSCRIPTEN__)
+	// The preloaded file system lives in memory already.
+	size_t size = 0;
+	void* data = SDL_LoadFile(path, &size);
+	if (!data) {
+		return false;
+	}
+	package->file = data;
+	package->base = data;
+	package->size = size;
+	return true;
+#else
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat st;
+	void* base = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	// The mapping keeps the file alive.
+	close(fd);
+	if (base == MAP_FAILED) {
+		return false;
+	}
+	package->base = base;
+	package->size = (u64)st.st_size;
+	return true;
+#endif
+}
+
+static void unmap_file(emp_package_t* package)
+{
+#if defined(_WIN32)
+	UnmapViewOfFile(package->base);
+	CloseHandle(package->mapping);
+	CloseHandle(package->file);
+#elif defined(__EMSCRIPTEN__)
+	SDL_free(package->file);
+#else
+	munmap((void*)package->base, (size_t)package->size);
+#endif
+}
+
+bool emp_package_open(emp_package_t* package, const char* path)
+{
+	SDL_zerop(package);
+	if (!map_file(package, path)) {
+		SDL_Log("Failed to map package '%s'", path);
+		return false;
+	}
+
+	const emp_package_header_t* header = (const emp_package_header_t*)package->base;
+	u64 table_end = sizeof(emp_package_header_t);
+	if (package->size >= table_end) {
+		table_end += (u64)header->count * sizeof(emp_package_entry_t);
+	}
+	if (package->size < table_end || header->magic != EMP_PACKAGE_MAGIC || header->version != EMP_PACKAGE_VERSION) {
+		SDL_Log("'%s' is not a version %d package", path, EMP_PACKAGE_VERSION);
+		unmap_file(package);
+		SDL_zerop(package);
+		return false;
+	}
+	package->count = header->count;
+	package->entries = (const emp_package_entry_t*)(package->base + sizeof(emp_package_header_t));
+	return true;
+}
+
+void emp_package_close(emp_package_t* package)
+{
+	if (package->base) {
+		unmap_file(package);
+	}
+	SDL_zerop(package);
+}
+
+void emp_package_bind(emp_package_t* package, emp_asset_t* asset, u32 index)
+{
+	if (index >= package->count) {
+		return;
+	}
+	const emp_package_entry_t* entry = &package->entries[index];
+	if (entry->offset + (entry->compressed_size ? entry->compressed_size : entry->size) > package->size) {
+		SDL_Log("Package entry for '%s' is out of bounds", asset->path);
+		return;
+	}
+	asset->package = package;
+	asset->package_index = index;
+	asset->hash = entry->hash;
+	if (entry->compressed_size == 0) {
+		asset->data.data = (u8*)package->base + entry->offset;
+		asset->data.size = entry->size;
+	}
+}
+
+void emp_package_load(emp_asset_t* asset)
+{
+	if (asset->data.data || !asset->package) {
+		return;
+	}
+	const emp_package_entry_t* entry = &asset->package->entries[asset->package_index];
+	u8* data = SDL_malloc(entry->size);
+	int size = LZ4_decompress_safe((const char*)asset->package->base + entry->offset, (char*)data,
+		(int)entry->compressed_size, (int)entry->size);
+	if (size != (int)entry->size) {
+		SDL_Log("Failed to decompress '%s' from the package", asset->path);
+		SDL_free(data);
+		return;
+	}
+	asset->data.data = data;
+	asset->data.size = entry->size;
+}
@@ -0,0 +1,86 @@
+#include <Empire/pool.h>
+#include <SDL3/SDL.h>
+
+void emp_pool_init(emp_pool_t* pool, u32 capacity)
+{
+	pool->slots = SDL_malloc(sizeof(emp_pool_slot_t) * capacity);
+	pool->dense = SDL_malloc(sizeof(u32) * capacity);
+	pool->capacity = capacity;
+	pool->high_water = 1;
+	SDL_memset(pool->slots, 0, sizeof(emp_pool_slot_t) * capacity);
+	emp_pool_clear(pool);
+}
+
+void emp_pool_destroy(emp_pool_t* pool)
+{
+	SDL_free(pool->slots);
+	SDL_free(pool->dense);
+	SDL_zerop(pool);
+}
+
+void emp_pool_clear(emp_pool_t* pool)
+{
+	// Generations survive a clear so handles from before the clear stay stale.
+	for (u32 i = 1; i < pool->capacity; ++i) {
+		emp_pool_slot_t* slot = &pool->slots[i];
+		slot->generation = slot->generation + (slot->generation & 1);
+		slot->next = i + 1 < pool->capacity ? i + 1 : 0;
+	}
+	pool->free_head = pool->capacity > 1 ? 1 : 0;
+	pool->count = 0;
+}
+
+u32 emp_pool_alloc(emp_pool_t* pool)
+{
+	u32 index = pool->free_head;
+	if (index == 0) {
+		return 0;
+	}
+
+	emp_pool_slot_t* slot = &pool->slots[index];
+	pool->free_head = slot->next;
+	slot->next = pool->count;
+	slot->generation++;
+	pool->dense[pool->count] = index;
+	pool->count++;
+	if (index >= pool->high_water) {
+		pool->high_water = index + 1;
+	}
+	return index;
+}
+
+u32 emp_pool_free(emp_pool_t* pool, u32 index)
+{
+	SDL_assert(emp_pool_is_alive(pool, index));
+
+	emp_pool_slot_t* slot = &pool->slots[index];
+	u32 hole = slot->next;
+	u32 last = pool->dense[pool->count - 1];
+	pool->dense[hole] = last;
+	pool->slots[last].next = hole;
+	pool->count--;
+
+	slot->generation++;
+	slot->next = pool->free_head;
+	pool->free_head = index;
+	return hole;
+}
+
+void emp_pool_restore_slots(emp_pool_t* pool, const void* slots, u32 high_water)
+{
+	u32 end = SDL_max(high_water, pool->high_water);
+	for (u32 i = 0; i < end; ++i) {
+		emp_pool_slot_t* slot = &pool->slots[i];
+		u32 retired = slot->generation + (slot->generation & 1);
+		if (i < high_water) {
+			SDL_memcpy(slot, (const u8*)slots + sizeof(emp_pool_slot_t) * i, sizeof(emp_pool_slot_t));
+			if ((slot->generation & 1) == 0 && slot->generation < retired) {
+				slot->generation = retired;
+			}
+		} else {
+			slot->generation = retired;
+			slot->next = i + 1 < pool->capacity ? i + 1 : 0;
+		}
+	}
+	pool->high_water = high_water;
+}
@@ -0,0 +1,158 @@
+#include "replay.h"
+
+#include <SDL3/SDL.h>
+
+#define EMP_REPLAY_MAGIC 0x52504d45u // "EMPR"
+// Version 1 stored mouse buttons as a byte; version 2 stores all 32 bits.
+#define EMP_REPLAY_VERSION 2u
+
+#define EMP_REPLAY_VIEW_CHANGED 0x1
+
+static bool write_f32(SDL_IOStream* io, float value)
+{
+	u32 bits;
+	SDL_memcpy(&bits, &value, sizeof(bits));
+	return SDL_WriteU32LE(io, bits);
+}
+
+static bool read_f32(SDL_IOStream* io, float* value)
+{
+	u32 bits;
+	if (!SDL_ReadU32LE(io, &bits)) {
+		return false;
+	}
+	SDL_memcpy(value, &bits, sizeof(bits));
+	return true;
+}
+
+static bool write_f64(SDL_IOStream* io, double value)
+{
+	u64 bits;
+	SDL_memcpy(&bits, &value, sizeof(bits));
+	return SDL_WriteU64LE(io, bits);
+}
+
+static bool read_f64(SDL_IOStream* io, double* value)
+{
+	u64 bits;
+	if (!SDL_ReadU64LE(io, &bits)) {
+		return false;
+	}
+	SDL_memcpy(value, &bits, sizeof(bits));
+	return true;
+}
+
+static bool read_buttons(emp_replay_t* replay, u32* buttons)
+{
+	if (replay->version >= 2) {
+		return SDL_ReadU32LE(replay->io, buttons);
+	}
+	u8 byte;
+	if (!SDL_ReadU8(replay->io, &byte)) {
+		return false;
+	}
+	*buttons = byte;
+	return true;
+}
+
+bool emp_replay_begin_record(emp_replay_t* replay, const char* path, u32 seed)
+{
+	SDL_zerop(replay);
+	replay->io = SDL_IOFromFile(path, "wb");
+	if (!replay->io) {
+		SDL_Log("Failed to open replay '%s' for writing: %s", path, SDL_GetError());
+		return false;
+	}
+	replay->seed = seed;
+	replay->version = EMP_REPLAY_VERSION;
+
+	if (!SDL_WriteU32LE(replay->io, EMP_REPLAY_MAGIC) || !SDL_WriteU32LE(replay->io, EMP_REPLAY_VERSION) || !SDL_WriteU32LE(replay->io, seed)) {
+		SDL_Log("Failed to write replay '%s': %s", path, SDL_GetError());
+		emp_replay_end(replay);
+		return false;
+	}
+	return true;
+}
+
+bool emp_replay_begin_playback(emp_replay_t* replay, const char* path)
+{
+	SDL_zerop(replay);
+	replay->io = SDL_IOFromFile(path, "rb");
+	if (!replay->io) {
+		SDL_Log("Failed to open replay '%s': %s", path, SDL_GetError());
+		return false;
+	}
+	replay->playing = true;
+
+	u32 magic = 0;
+	if (!SDL_ReadU32LE(replay->io, &magic) || !SDL_ReadU32LE(replay->io, &replay->version) || !SDL_ReadU32LE(replay->io, &replay->seed)
+		|| magic != EMP_REPLAY_MAGIC || replay->version == 0 || replay->version > EMP_REPLAY_VERSION) {
+		SDL_Log("'%s' is not a version 1 to %u replay", path, EMP_REPLAY_VERSION);
+		emp_replay_end(replay);
+		return false;
+	}
+	return true;
+}
+
+void emp_replay_end(emp_replay_t* replay)
+{
+	if (replay->io) {
+		SDL_CloseIO(replay->io);
+	}
+	SDL_zerop(replay);
+}
+
+bool emp_replay_write(emp_replay_t* replay, const emp_replay_frame_t* frame)
+{
+	SDL_IOStream* io = replay->io;
+	bool view_changed = replay->frames == 0
+		|| frame->view_size.x != replay->last.view_size.x
+		|| frame->view_size.y != replay->last.view_size.y
+		|| frame->magnification != replay->last.magnification;
+
+	bool ok = SDL_WriteU8(io, view_changed ? EMP_REPLAY_VIEW_CHANGED : 0)
+		&& write_f64(io, frame->dt)
+		&& SDL_WriteU32LE(io, frame->input.keys)
+		&& SDL_WriteU32LE(io, frame->input.buttons)
+		&& write_f32(io, frame->input.mouse.x)
+		&& write_f32(io, frame->input.mouse.y);
+	if (ok && view_changed) {
+		ok = write_f32(io, frame->view_size.x)
+			&& write_f32(io, frame->view_size.y)
+			&& write_f32(io, frame->magnification);
+	}
+	if (!ok) {
+		return false;
+	}
+
+	replay->last = *frame;
+	replay->frames++;
+	return true;
+}
+
+bool emp_replay_read(emp_replay_t* replay, emp_replay_frame_t* frame)
+{
+	SDL_IOStream* io = replay->io;
+	emp_replay_frame_t next = replay->last;
+
+	u8 flags;
+	if (!SDL_ReadU8(io, &flags)
+		|| !read_f64(io, &next.dt)
+		|| !SDL_ReadU32LE(io, &next.input.keys)
+		|| !read_buttons(replay, &next.input.buttons)
+		|| !read_f32(io, &next.input.mouse.x)
+		|| !read_f32(io, &next.input.mouse.y)) {
+		return false;
+	}
+
+	if (flags & EMP_REPLAY_VIEW_CHANGED) {
+		if (!read_f32(io, &next.view_size.x) || !read_f32(io, &next.view_size.y) || !read_f32(io, &next.magnification)) {
+			return false;
+		}
+	}
+
+	replay->last = next;
+	replay->frames++;
+	*frame = next;
+	return true;
+}
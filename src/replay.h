@@ -0,0 +1,36 @@
+#pragma once
+
+#include "entities.h"
+
+#include <SDL3/SDL_iostream.h>
+
+// Everything the simulation consumed on one frame. Replaying the frames of a
+// log in order, from the same seed and level, reproduces the session.
+typedef struct emp_replay_frame_t
+{
+	double dt;
+	emp_input_t input;
+	emp_vec2_t view_size;
+	float magnification;
+} emp_replay_frame_t;
+
+// Binary input log: a header with the RNG seed, then one record per frame.
+// View size and magnification are only written when they change.
+typedef struct emp_replay_t
+{
+	SDL_IOStream* io;
+	bool playing;
+	u32 version;
+	u32 seed;
+	u64 frames;
+	emp_replay_frame_t last;
+} emp_replay_t;
+
+bool emp_replay_begin_record(emp_replay_t* replay, const char* path, u32 seed);
+bool emp_replay_begin_playback(emp_replay_t* replay, const char* path);
+void emp_replay_end(emp_replay_t* replay);
+
+// Returns false when the frame could not be written.
+bool emp_replay_write(emp_replay_t* replay, const emp_replay_frame_t* frame);
+// Returns false once the log is exhausted.
+bool emp_replay_read(emp_replay_t* replay, emp_replay_frame_t* frame);
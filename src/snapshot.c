@@ -0,0 +1,766 @@
+#include "snapshot.h"
+#include "entities.h"
+
+#include <Empire/lz4.h>
+#include <Empire/util.h>
+#include <SDL3/SDL.h>
+
+// Pooled entities are stored as the pool's slot table followed by the live
+// entities in dense order, so the snapshot only grows with the live count.
+// Slots past the high water mark were never allocated and are not stored.
+static u64 pool_snapshot_size(emp_pool_t* pool, u64 entity_size)
+{
+	return sizeof(pool->free_head) + sizeof(pool->count) + sizeof(pool->high_water) + sizeof(emp_pool_slot_t) * pool->high_water + (sizeof(u32) + entity_size) * pool->count;
+}
+
+static u64 write_pool_snapshot(u8* dst, emp_pool_t* pool, const void* entities, u64 entity_size)
+{
+	u64 write_pos = 0;
+
+	SDL_memcpy(dst + write_pos, &pool->free_head, sizeof(pool->free_head));
+	write_pos += sizeof(pool->free_head);
+
+	SDL_memcpy(dst + write_pos, &pool->count, sizeof(pool->count));
+	write_pos += sizeof(pool->count);
+
+	SDL_memcpy(dst + write_pos, &pool->high_water, sizeof(pool->high_water));
+	write_pos += sizeof(pool->high_water);
+
+	SDL_memcpy(dst + write_pos, pool->slots, sizeof(emp_pool_slot_t) * pool->high_water);
+	write_pos += sizeof(emp_pool_slot_t) * pool->high_water;
+
+	SDL_memcpy(dst + write_pos, pool->dense, sizeof(u32) * pool->count);
+	write_pos += sizeof(u32) * pool->count;
+
+	for (u32 i = 0; i < pool->count && entities; ++i) {
+		SDL_memcpy(dst + write_pos, (const u8*)entities + pool->dense[i] * entity_size, entity_size);
+		write_pos += entity_size;
+	}
+
+	return write_pos;
+}
+
+static u64 read_pool_snapshot(const u8* src, emp_pool_t* pool, void* entities, u64 entity_size)
+{
+	u64 read_pos = 0;
+
+	SDL_memcpy(&pool->free_head, src + read_pos, sizeof(pool->free_head));
+	read_pos += sizeof(pool->free_head);
+
+	SDL_memcpy(&pool->count, src + read_pos, sizeof(pool->count));
+	read_pos += sizeof(pool->count);
+
+	u32 high_water;
+	SDL_memcpy(&high_water, src + read_pos, sizeof(high_water));
+	read_pos += sizeof(high_water);
+
+	emp_pool_restore_slots(pool, src + read_pos, high_water);
+	read_pos += sizeof(emp_pool_slot_t) * high_water;
+
+	SDL_memcpy(pool->dense, src + read_pos, sizeof(u32) * pool->count);
+	read_pos += sizeof(u32) * pool->count;
+
+	for (u32 i = 0; i < pool->count && entities; ++i) {
+		SDL_memcpy((u8*)entities + pool->dense[i] * entity_size, src + read_pos, entity_size);
+		read_pos += entity_size;
+	}
+
+	return read_pos;
+}
+
+#define SNAPSHOT_BULLET_STREAMS 9
+// The leading bullet streams emp_bullets_integrate advances: x, y, vx, vy, life.
+#define SNAPSHOT_PREDICTED_STREAMS 5
+#define SNAPSHOT_MAX_PREDICTED_STEPS 4096
+#define SNAPSHOT_CHUNK_BYTES (EMP_CHUNK_TILES * EMP_CHUNK_TILES * sizeof(emp_tile_health_t))
+
+// Sections are XORed against the same section of the keyframe, so a change in
+// one entity count does not shift the bytes of every section after it.
+typedef enum snapshot_section {
+	snapshot_section_args,
+	snapshot_section_players,
+	snapshot_section_enemies,
+	snapshot_section_spawners,
+	snapshot_section_bullet_pool,
+	snapshot_section_bullet_streams,
+	snapshot_section_count = snapshot_section_bullet_streams + SNAPSHOT_BULLET_STREAMS,
+} snapshot_section;
+
+// Raw layout: header, sections, then tile health. A keyframe stores the
+// whole health grid; a delta stores `chunk_count` chunk indices followed by
+// those chunks' health, row by row.
+typedef struct snapshot_header_t
+{
+	u32 is_keyframe;
+	u32 chunk_count;
+	u64 section_size[snapshot_section_count];
+} snapshot_header_t;
+
+// Bullet streams are already packed in dense order, so each one is a single copy.
+static void bullet_streams(void** streams, u64* sizes)
+{
+	emp_bullets_t* b = G->bullets;
+	void* s[SNAPSHOT_BULLET_STREAMS] = { b->x, b->y, b->vx, b->vy, b->life, b->damage, b->mask, b->texture_asset, b->custom_render };
+	u64 z[SNAPSHOT_BULLET_STREAMS] = { sizeof(*b->x), sizeof(*b->y), sizeof(*b->vx), sizeof(*b->vy), sizeof(*b->life), sizeof(*b->damage), sizeof(*b->mask), sizeof(*b->texture_asset), sizeof(*b->custom_render) };
+	SDL_memcpy(streams, s, sizeof(s));
+	SDL_memcpy(sizes, z, sizeof(z));
+}
+
+static void reserve(emp_buffer* buffer, u64 size)
+{
+	if (buffer->size < size) {
+		buffer->data = SDL_realloc(buffer->data, size);
+		buffer->size = size;
+	}
+}
+
+static u32 count_chunks(const u64* flags)
+{
+	u32 count = 0;
+	for (u32 w = 0; w < EMP_LEVEL_CHUNKS / 64; ++w) {
+		for (u64 bits = flags[w]; bits; bits &= bits - 1) {
+			count++;
+		}
+	}
+	return count;
+}
+
+static void copy_health_chunk(emp_tile_health_t* grid, u8* snapshot, u32 chunk, bool restore)
+{
+	u32 cx = chunk % EMP_LEVEL_CHUNKS_X;
+	u32 cy = chunk / EMP_LEVEL_CHUNKS_X;
+	emp_tile_health_t* row = grid + (u64)cy * EMP_CHUNK_TILES * EMP_LEVEL_WIDTH + cx * EMP_CHUNK_TILES;
+	u64 row_bytes = EMP_CHUNK_TILES * sizeof(emp_tile_health_t);
+
+	for (u32 y = 0; y < EMP_CHUNK_TILES; ++y) {
+		if (restore) {
+			SDL_memcpy(row, snapshot, row_bytes);
+		} else {
+			SDL_memcpy(snapshot, row, row_bytes);
+		}
+		row += EMP_LEVEL_WIDTH;
+		snapshot += row_bytes;
+	}
+}
+
+// Writes the `count` chunks flagged in `flags` as chunk indices followed by
+// their health, row by row, and returns the bytes written.
+static u64 write_health_chunks(u8* dst, emp_tile_health_t* grid, const u64* flags, u32 count)
+{
+	u8* chunk_data = dst + sizeof(u32) * count;
+	u32 n = 0;
+	for (u32 chunk = 0; chunk < EMP_LEVEL_CHUNKS; ++chunk) {
+		if (flags[chunk >> 6] & ((u64)1 << (chunk & 63))) {
+			SDL_memcpy(dst + sizeof(u32) * n, &chunk, sizeof(chunk));
+			copy_health_chunk(grid, chunk_data + SNAPSHOT_CHUNK_BYTES * n, chunk, false);
+			n++;
+		}
+	}
+	SDL_assert(n == count);
+	return (sizeof(u32) + SNAPSHOT_CHUNK_BYTES) * count;
+}
+
+static u64 sections_size(const snapshot_header_t* header)
+{
+	u64 size = 0;
+	for (u32 i = 0; i < snapshot_section_count; ++i) {
+		size += header->section_size[i];
+	}
+	return size;
+}
+
+// Serialises the live state into `buffer` and returns its size. With
+// `whole_grid` the full health grid is stored, as in a keyframe; otherwise
+// only the chunks flagged in emp_level_t::health_dirty are.
+static u64 write_state(emp_buffer* buffer, bool keyframe, bool whole_grid)
+{
+	snapshot_header_t header = { .is_keyframe = keyframe };
+	header.section_size[snapshot_section_args] = sizeof(emp_update_args_t);
+	header.section_size[snapshot_section_players] = sizeof(emp_player_t) * EMP_MAX_PLAYERS;
+	header.section_size[snapshot_section_enemies] = pool_snapshot_size(&G->enemy_pool, sizeof(emp_enemy_t));
+	header.section_size[snapshot_section_spawners] = pool_snapshot_size(&G->spawner_pool, sizeof(emp_spawner_t));
+	header.section_size[snapshot_section_bullet_pool] = pool_snapshot_size(&G->bullet_pool, 0);
+
+	void* streams[SNAPSHOT_BULLET_STREAMS];
+	u64 stream_sizes[SNAPSHOT_BULLET_STREAMS];
+	bullet_streams(streams, stream_sizes);
+	for (u32 i = 0; i < SNAPSHOT_BULLET_STREAMS; ++i) {
+		header.section_size[snapshot_section_bullet_streams + i] = stream_sizes[i] * G->bullet_pool.count;
+	}
+
+	u64 health_size;
+	if (whole_grid) {
+		health_size = sizeof(emp_tile_health_t) * EMP_LEVEL_TILES;
+	} else {
+		header.chunk_count = count_chunks(G->level->health_dirty);
+		health_size = (sizeof(u32) + SNAPSHOT_CHUNK_BYTES) * header.chunk_count;
+	}
+
+	u64 total_size = sizeof(header) + sections_size(&header) + health_size;
+	reserve(buffer, total_size);
+
+	u8* dst = buffer->data;
+	u64 write_pos = 0;
+
+	SDL_memcpy(dst + write_pos, &header, sizeof(header));
+	write_pos += sizeof(header);
+
+	SDL_memcpy(dst + write_pos, G->args, sizeof(emp_update_args_t));
+	write_pos += sizeof(emp_update_args_t);
+
+	SDL_memcpy(dst + write_pos, G->player, sizeof(emp_player_t) * EMP_MAX_PLAYERS);
+	write_pos += sizeof(emp_player_t) * EMP_MAX_PLAYERS;
+
+	write_pos += write_pool_snapshot(dst + write_pos, &G->enemy_pool, G->enemies, sizeof(emp_enemy_t));
+	write_pos += write_pool_snapshot(dst + write_pos, &G->spawner_pool, G->spawners, sizeof(emp_spawner_t));
+	write_pos += write_pool_snapshot(dst + write_pos, &G->bullet_pool, NULL, 0);
+
+	for (u32 i = 0; i < SNAPSHOT_BULLET_STREAMS; ++i) {
+		u64 size = stream_sizes[i] * G->bullet_pool.count;
+		SDL_memcpy(dst + write_pos, streams[i], size);
+		write_pos += size;
+	}
+
+	if (whole_grid) {
+		SDL_memcpy(dst + write_pos, G->level->health, health_size);
+		write_pos += health_size;
+	} else {
+		write_pos += write_health_chunks(dst + write_pos, G->level->health, G->level->health_dirty, header.chunk_count);
+	}
+
+	SDL_assert(write_pos == total_size);
+	return write_pos;
+}
+
+// Offset of every section of a raw state.
+static void section_offsets(const u8* state, u64* offsets)
+{
+	snapshot_header_t header;
+	SDL_memcpy(&header, state, sizeof(header));
+	u64 pos = sizeof(header);
+	for (u32 i = 0; i < snapshot_section_count; ++i) {
+		offsets[i] = pos;
+		pos += header.section_size[i];
+	}
+}
+
+// XORs the sections before the bullet streams of `state` in place with the
+// matching sections of the keyframe `base`. Bytes past the end of the base
+// section are left as they are.
+static void xor_sections(u8* state, const u8* base)
+{
+	snapshot_header_t header;
+	snapshot_header_t base_header;
+	SDL_memcpy(&header, state, sizeof(header));
+	SDL_memcpy(&base_header, base, sizeof(base_header));
+
+	u64 pos = sizeof(header);
+	u64 base_pos = sizeof(base_header);
+	for (u32 i = 0; i < snapshot_section_bullet_streams; ++i) {
+		u64 size = SDL_min(header.section_size[i], base_header.section_size[i]);
+		u8* dst = state + pos;
+		const u8* src = base + base_pos;
+		for (u64 b = 0; b < size; ++b) {
+			dst[b] ^= src[b];
+		}
+		pos += header.section_size[i];
+		base_pos += base_header.section_size[i];
+	}
+}
+
+// A pool section read in place; the slot table and dense array may be unaligned.
+typedef struct pool_view_t
+{
+	u32 count;
+	u32 high_water;
+	const u8* slots;
+	const u8* dense;
+} pool_view_t;
+
+static pool_view_t view_pool_snapshot(const u8* src)
+{
+	pool_view_t view;
+	SDL_memcpy(&view.count, src + sizeof(u32), sizeof(view.count));
+	SDL_memcpy(&view.high_water, src + sizeof(u32) * 2, sizeof(view.high_water));
+	view.slots = src + sizeof(u32) * 3;
+	view.dense = view.slots + sizeof(emp_pool_slot_t) * view.high_water;
+	return view;
+}
+
+// Dense position in `base` of the entity at dense position `at` in `current`,
+// or SDL_MAX_UINT32 when it was allocated after `base` was taken.
+static u32 base_position(const pool_view_t* current, const pool_view_t* base, u32 at)
+{
+	u32 index;
+	SDL_memcpy(&index, current->dense + sizeof(u32) * at, sizeof(index));
+	if (index >= base->high_water) {
+		return SDL_MAX_UINT32;
+	}
+	emp_pool_slot_t now;
+	emp_pool_slot_t then;
+	SDL_memcpy(&now, current->slots + sizeof(emp_pool_slot_t) * index, sizeof(now));
+	SDL_memcpy(&then, base->slots + sizeof(emp_pool_slot_t) * index, sizeof(then));
+	return now.generation == then.generation ? then.next : SDL_MAX_UINT32;
+}
+
+static void reserve_prediction(emp_bullet_prediction_t* prediction, u32 count)
+{
+	if (prediction->capacity >= count) {
+		return;
+	}
+	u32 capacity = SDL_max(count, prediction->capacity * 2);
+	for (u32 i = 0; i < SNAPSHOT_PREDICTED_STREAMS; ++i) {
+		SDL_aligned_free(prediction->streams[i]);
+		prediction->streams[i] = SDL_aligned_alloc(32, sizeof(float) * capacity);
+	}
+	prediction->base_at = SDL_realloc(prediction->base_at, sizeof(u32) * capacity);
+	prediction->capacity = capacity;
+}
+
+static void free_prediction(emp_bullet_prediction_t* prediction)
+{
+	for (u32 i = 0; i < SNAPSHOT_PREDICTED_STREAMS; ++i) {
+		SDL_aligned_free(prediction->streams[i]);
+	}
+	SDL_free(prediction->base_at);
+	SDL_zerop(prediction);
+}
+
+// Bullet streams are coded per bullet rather than per byte offset, since the
+// dense order shuffles as bullets die. Each bullet is XORed with the same
+// bullet in the keyframe, found through the pool's slot table, after its
+// keyframe position and life have been run through emp_bullets_integrate for
+// the steps between the two states. A bullet that only flew on codes to zero
+// bytes; one spawned after the keyframe is stored as is. The args and bullet
+// pool sections of `state` must be plain when this runs.
+static void xor_bullets(u8* state, const u8* base, emp_bullet_prediction_t* prediction)
+{
+	u64 offsets[snapshot_section_count];
+	u64 base_offsets[snapshot_section_count];
+	section_offsets(state, offsets);
+	section_offsets(base, base_offsets);
+
+	pool_view_t current = view_pool_snapshot(state + offsets[snapshot_section_bullet_pool]);
+	pool_view_t keyframe = view_pool_snapshot(base + base_offsets[snapshot_section_bullet_pool]);
+
+	emp_update_args_t now;
+	emp_update_args_t then;
+	SDL_memcpy(&now, state + offsets[snapshot_section_args], sizeof(now));
+	SDL_memcpy(&then, base + base_offsets[snapshot_section_args], sizeof(then));
+	u32 steps = 0;
+	if (now.dt > 0.0f) {
+		double elapsed = SDL_round((now.global_time - then.global_time) / (double)now.dt);
+		steps = (u32)SDL_clamp(elapsed, 0.0, (double)SNAPSHOT_MAX_PREDICTED_STEPS);
+	}
+
+	reserve_prediction(prediction, current.count);
+	for (u32 i = 0; i < current.count; ++i) {
+		u32 at = base_position(&current, &keyframe, i);
+		prediction->base_at[i] = at;
+		for (u32 s = 0; s < SNAPSHOT_PREDICTED_STREAMS; ++s) {
+			float value = 0.0f;
+			if (at != SDL_MAX_UINT32) {
+				SDL_memcpy(&value, base + base_offsets[snapshot_section_bullet_streams + s] + sizeof(float) * at, sizeof(value));
+			}
+			prediction->streams[s][i] = value;
+		}
+	}
+
+	emp_bullets_t predicted = {
+		.x = prediction->streams[0],
+		.y = prediction->streams[1],
+		.vx = prediction->streams[2],
+		.vy = prediction->streams[3],
+		.life = prediction->streams[4],
+	};
+	for (u32 step = 0; step < steps; ++step) {
+		emp_bullets_integrate(&predicted, current.count, now.dt);
+	}
+
+	void* streams[SNAPSHOT_BULLET_STREAMS];
+	u64 stream_sizes[SNAPSHOT_BULLET_STREAMS];
+	bullet_streams(streams, stream_sizes);
+	for (u32 s = 0; s < SNAPSHOT_BULLET_STREAMS; ++s) {
+		u64 size = stream_sizes[s];
+		u8* dst = state + offsets[snapshot_section_bullet_streams + s];
+		const u8* src = base + base_offsets[snapshot_section_bullet_streams + s];
+		for (u32 i = 0; i < current.count; ++i) {
+			u32 at = prediction->base_at[i];
+			if (at == SDL_MAX_UINT32) {
+				continue;
+			}
+			const u8* guess = s < SNAPSHOT_PREDICTED_STREAMS ? (const u8*)&prediction->streams[s][i] : src + size * at;
+			for (u64 b = 0; b < size; ++b) {
+				dst[size * i + b] ^= guess[b];
+			}
+		}
+	}
+}
+
+// Codes the delta `state` against the keyframe `base` in place; coding twice
+// is the identity. Bullets are predicted from the plain args and pool
+// sections, so they are coded first when encoding and last when decoding.
+static void xor_delta(u8* state, const u8* base, emp_bullet_prediction_t* prediction, bool decode)
+{
+	if (!decode) {
+		xor_bullets(state, base, prediction);
+	}
+	xor_sections(state, base);
+	if (decode) {
+		xor_bullets(state, base, prediction);
+	}
+}
+
+// Applies a decoded state. A delta's health chunks are patched over the
+// keyframe's grid, which `base` must hold.
+static void read_state(const u8* state, const u8* base)
+{
+	snapshot_header_t header;
+	SDL_memcpy(&header, state, sizeof(header));
+
+	u64 read_pos = sizeof(header);
+
+	SDL_memcpy(G->args, state + read_pos, sizeof(emp_update_args_t));
+	read_pos += sizeof(emp_update_args_t);
+
+	SDL_memcpy(G->player, state + read_pos, sizeof(emp_player_t) * EMP_MAX_PLAYERS);
+	read_pos += sizeof(emp_player_t) * EMP_MAX_PLAYERS;
+
+	read_pos += read_pool_snapshot(state + read_pos, &G->enemy_pool, G->enemies, sizeof(emp_enemy_t));
+	read_pos += read_pool_snapshot(state + read_pos, &G->spawner_pool, G->spawners, sizeof(emp_spawner_t));
+	read_pos += read_pool_snapshot(state + read_pos, &G->bullet_pool, NULL, 0);
+
+	void* streams[SNAPSHOT_BULLET_STREAMS];
+	u64 stream_sizes[SNAPSHOT_BULLET_STREAMS];
+	bullet_streams(streams, stream_sizes);
+	for (u32 i = 0; i < SNAPSHOT_BULLET_STREAMS; ++i) {
+		u64 size = stream_sizes[i] * G->bullet_pool.count;
+		SDL_memcpy(streams[i], state + read_pos, size);
+		read_pos += size;
+	}
+
+	u64 health_size = sizeof(emp_tile_health_t) * EMP_LEVEL_TILES;
+	if (header.is_keyframe) {
+		SDL_memcpy(G->level->health, state + read_pos, health_size);
+	} else {
+		SDL_assert(base);
+		snapshot_header_t base_header;
+		SDL_memcpy(&base_header, base, sizeof(base_header));
+		u64 base_health = sizeof(base_header);
+		for (u32 i = 0; i < snapshot_section_count; ++i) {
+			base_health += base_header.section_size[i];
+		}
+		SDL_memcpy(G->level->health, base + base_health, health_size);
+
+		const u8* chunk_data = state + read_pos + sizeof(u32) * header.chunk_count;
+		for (u32 n = 0; n < header.chunk_count; ++n) {
+			u32 chunk;
+			SDL_memcpy(&chunk, state + read_pos + sizeof(u32) * n, sizeof(chunk));
+			copy_health_chunk(G->level->health, (u8*)chunk_data + SNAPSHOT_CHUNK_BYTES * n, chunk, true);
+		}
+	}
+
+	// The restored grid no longer matches whatever keyframe came before.
+	SDL_memset(G->level->health_dirty, 0xff, sizeof(G->level->health_dirty));
+	emp_level_rebuild_breakable();
+}
+
+static void decompress_into(emp_buffer* buffer, emp_compressed_buffer compressed)
+{
+	reserve(buffer, compressed.original_size);
+	LZ4_decompress_safe((const char*)compressed.data, (char*)buffer->data, (int)compressed.compressed_size, (int)compressed.original_size);
+}
+
+emp_compressed_buffer write_game_snapshot(void)
+{
+	static emp_buffer scratch_buffer;
+	u64 size = write_state(&scratch_buffer, true, true);
+	return emp_compress_buffer((emp_buffer) { .size = size, .data = scratch_buffer.data });
+}
+
+void restore_game_snapshot(emp_compressed_buffer compressed_buffer)
+{
+	emp_buffer state_buffer = emp_decompress_buffer(compressed_buffer);
+	read_state(state_buffer.data, NULL);
+	emp_free_buffer(&state_buffer);
+}
+
+// Patches the worker's copy of the health grid with the chunks a staged
+// state carries and flags them as changed since the keyframe.
+static void apply_staged_health(emp_rewind_t* rewind, const u8* staged)
+{
+	snapshot_header_t header;
+	SDL_memcpy(&header, staged, sizeof(header));
+	const u8* chunk_ids = staged + sizeof(header) + sections_size(&header);
+	const u8* chunk_data = chunk_ids + sizeof(u32) * header.chunk_count;
+	for (u32 n = 0; n < header.chunk_count; ++n) {
+		u32 chunk;
+		SDL_memcpy(&chunk, chunk_ids + sizeof(u32) * n, sizeof(chunk));
+		copy_health_chunk(rewind->health, (u8*)chunk_data + SNAPSHOT_CHUNK_BYTES * n, chunk, true);
+		rewind->health_changed[chunk >> 6] |= (u64)1 << (chunk & 63);
+	}
+}
+
+// Lays out the record for a staged state in `out`: its header and sections,
+// then the whole health grid for a keyframe, or for a delta the chunks that
+// changed since the keyframe.
+static u64 build_record(emp_rewind_t* rewind, const u8* staged, bool keyframe, emp_buffer* out)
+{
+	snapshot_header_t header;
+	SDL_memcpy(&header, staged, sizeof(header));
+	u64 sections = sections_size(&header);
+
+	u64 health_size;
+	if (keyframe) {
+		header.chunk_count = 0;
+		health_size = sizeof(emp_tile_health_t) * EMP_LEVEL_TILES;
+	} else {
+		header.chunk_count = count_chunks(rewind->health_changed);
+		health_size = (sizeof(u32) + SNAPSHOT_CHUNK_BYTES) * header.chunk_count;
+	}
+	u64 size = sizeof(header) + sections + health_size;
+	reserve(out, size);
+
+	u8* dst = out->data;
+	SDL_memcpy(dst, &header, sizeof(header));
+	SDL_memcpy(dst + sizeof(header), staged + sizeof(header), sections);
+	if (keyframe) {
+		SDL_memcpy(dst + sizeof(header) + sections, rewind->health, health_size);
+	} else {
+		write_health_chunks(dst + sizeof(header) + sections, rewind->health, rewind->health_changed, header.chunk_count);
+	}
+	return size;
+}
+
+// Codes a staged state and compresses it. Jobs run in submission order, so a
+// delta always finds the keyframe it was recorded against in `keyframe`.
+static emp_compressed_buffer encode_job(emp_rewind_t* rewind, emp_rewind_job_t job)
+{
+	const u8* staged = rewind->staging[job.staging].data;
+	apply_staged_health(rewind, staged);
+	if (job.keyframe) {
+		SDL_memset(rewind->health_changed, 0, sizeof(u64) * (EMP_LEVEL_CHUNKS / 64));
+		u64 size = build_record(rewind, staged, true, &rewind->keyframe);
+		return emp_compress_buffer((emp_buffer) { .size = size, .data = rewind->keyframe.data });
+	}
+	u64 size = build_record(rewind, staged, false, &rewind->record);
+	xor_delta(rewind->record.data, rewind->keyframe.data, &rewind->encode_prediction, false);
+	return emp_compress_buffer((emp_buffer) { .size = size, .data = rewind->record.data });
+}
+
+// Codes staged states in submission order and publishes each result into
+// its ring slot.
+static int SDLCALL rewind_worker(void* data)
+{
+	emp_rewind_t* rewind = data;
+
+	SDL_LockMutex(rewind->lock);
+	for (;;) {
+		while (!rewind->quit && rewind->job_count == 0) {
+			SDL_WaitCondition(rewind->wake, rewind->lock);
+		}
+		if (rewind->job_count == 0) {
+			break;
+		}
+		emp_rewind_job_t job = rewind->jobs[0];
+		SDL_UnlockMutex(rewind->lock);
+
+		emp_compressed_buffer compressed = encode_job(rewind, job);
+
+		SDL_LockMutex(rewind->lock);
+		rewind->ring[job.slot].data = compressed;
+		rewind->ring[job.slot].pending = false;
+		rewind->staging_busy[job.staging] = false;
+		rewind->jobs[0] = rewind->jobs[1];
+		rewind->job_count--;
+		SDL_BroadcastCondition(rewind->done);
+	}
+	SDL_UnlockMutex(rewind->lock);
+	return 0;
+}
+
+static void wait_for_slot(emp_rewind_t* rewind, u32 slot)
+{
+	if (!rewind->worker) {
+		return;
+	}
+	SDL_LockMutex(rewind->lock);
+	while (rewind->ring[slot].pending) {
+		SDL_WaitCondition(rewind->done, rewind->lock);
+	}
+	SDL_UnlockMutex(rewind->lock);
+}
+
+static u32 acquire_staging(emp_rewind_t* rewind)
+{
+	if (!rewind->worker) {
+		return 0;
+	}
+	SDL_LockMutex(rewind->lock);
+	while (rewind->staging_busy[0] && rewind->staging_busy[1]) {
+		SDL_WaitCondition(rewind->done, rewind->lock);
+	}
+	u32 staging = rewind->staging_busy[0] ? 1 : 0;
+	rewind->staging_busy[staging] = true;
+	SDL_UnlockMutex(rewind->lock);
+	return staging;
+}
+
+static void submit(emp_rewind_t* rewind, emp_rewind_job_t job)
+{
+	if (!rewind->worker) {
+		rewind->ring[job.slot].data = encode_job(rewind, job);
+		return;
+	}
+	SDL_LockMutex(rewind->lock);
+	rewind->ring[job.slot].pending = true;
+	rewind->jobs[rewind->job_count++] = job;
+	SDL_SignalCondition(rewind->wake);
+	SDL_UnlockMutex(rewind->lock);
+}
+
+void emp_rewind_init(emp_rewind_t* rewind, u32 capacity, u32 keyframe_interval)
+{
+	SDL_assert((capacity & (capacity - 1)) == 0);
+	SDL_zerop(rewind);
+	rewind->ring = SDL_calloc(capacity, sizeof(emp_snapshot_t));
+	rewind->capacity = capacity;
+	rewind->keyframe_interval = keyframe_interval;
+	rewind->next_serial = 1;
+	rewind->force_keyframe = true;
+	rewind->health = SDL_calloc(EMP_LEVEL_TILES, sizeof(emp_tile_health_t));
+	rewind->health_changed = SDL_calloc(EMP_LEVEL_CHUNKS / 64, sizeof(u64));
+
+	rewind->lock = SDL_CreateMutex();
+	rewind->wake = SDL_CreateCondition();
+	rewind->done = SDL_CreateCondition();
+	rewind->worker = SDL_CreateThread(rewind_worker, "rewind", rewind);
+	if (!rewind->worker) {
+		SDL_Log("Rewind snapshots compress on the main thread: %s", SDL_GetError());
+	}
+}
+
+void emp_rewind_flush(emp_rewind_t* rewind)
+{
+	if (!rewind->worker) {
+		return;
+	}
+	SDL_LockMutex(rewind->lock);
+	while (rewind->job_count > 0) {
+		SDL_WaitCondition(rewind->done, rewind->lock);
+	}
+	SDL_UnlockMutex(rewind->lock);
+}
+
+void emp_rewind_destroy(emp_rewind_t* rewind)
+{
+	if (rewind->worker) {
+		SDL_LockMutex(rewind->lock);
+		rewind->quit = true;
+		SDL_SignalCondition(rewind->wake);
+		SDL_UnlockMutex(rewind->lock);
+		SDL_WaitThread(rewind->worker, NULL);
+	}
+	SDL_DestroyCondition(rewind->done);
+	SDL_DestroyCondition(rewind->wake);
+	SDL_DestroyMutex(rewind->lock);
+
+	for (u32 i = 0; i < rewind->capacity; ++i) {
+		SDL_free(rewind->ring[i].data.data);
+	}
+	SDL_free(rewind->ring);
+	emp_free_buffer(&rewind->base);
+	emp_free_buffer(&rewind->keyframe);
+	emp_free_buffer(&rewind->record);
+	SDL_free(rewind->health);
+	SDL_free(rewind->health_changed);
+	emp_free_buffer(&rewind->scratch);
+	free_prediction(&rewind->encode_prediction);
+	free_prediction(&rewind->decode_prediction);
+	emp_free_buffer(&rewind->staging[0]);
+	emp_free_buffer(&rewind->staging[1]);
+	SDL_zerop(rewind);
+}
+
+void emp_rewind_record(emp_rewind_t* rewind)
+{
+	bool keyframe = rewind->force_keyframe || rewind->since_keyframe >= rewind->keyframe_interval;
+	u32 slot = rewind->head;
+	wait_for_slot(rewind, slot);
+
+	emp_snapshot_t* snapshot = &rewind->ring[slot];
+	SDL_free(snapshot->data.data);
+	SDL_zerop(snapshot);
+	snapshot->serial = rewind->next_serial++;
+
+	// The worker keeps its own copy of the health grid, so only chunks that
+	// changed since the last record are copied here. A forced keyframe
+	// resyncs that copy from scratch.
+	if (rewind->force_keyframe) {
+		SDL_memset(G->level->health_dirty, 0xff, sizeof(G->level->health_dirty));
+	}
+	u32 staging = acquire_staging(rewind);
+	write_state(&rewind->staging[staging], keyframe, false);
+	SDL_memset(G->level->health_dirty, 0, sizeof(G->level->health_dirty));
+	if (keyframe) {
+		rewind->keyframe_serial = snapshot->serial;
+		rewind->keyframe_slot = slot;
+		rewind->since_keyframe = 0;
+		rewind->force_keyframe = false;
+	} else {
+		rewind->since_keyframe++;
+	}
+	snapshot->keyframe_serial = rewind->keyframe_serial;
+	snapshot->keyframe_slot = rewind->keyframe_slot;
+	submit(rewind, (emp_rewind_job_t) { .slot = slot, .staging = staging, .keyframe = keyframe });
+
+	rewind->head = (rewind->head + 1) & (rewind->capacity - 1);
+	rewind->count = SDL_min(rewind->count + 1, rewind->capacity);
+}
+
+bool emp_rewind_restore_latest(emp_rewind_t* rewind)
+{
+	if (rewind->count == 0) {
+		return false;
+	}
+
+	u32 slot = (rewind->head - 1) & (rewind->capacity - 1);
+	wait_for_slot(rewind, slot);
+	emp_snapshot_t* snapshot = &rewind->ring[slot];
+	bool keyframe = snapshot->serial == snapshot->keyframe_serial;
+
+	if (!keyframe && rewind->base_serial != snapshot->keyframe_serial) {
+		emp_snapshot_t* key = &rewind->ring[snapshot->keyframe_slot];
+		wait_for_slot(rewind, snapshot->keyframe_slot);
+		if (key->serial != snapshot->keyframe_serial) {
+			return false;
+		}
+		decompress_into(&rewind->base, key->data);
+		rewind->base_serial = key->serial;
+		rewind->base_slot = snapshot->keyframe_slot;
+	}
+
+	decompress_into(&rewind->scratch, snapshot->data);
+	if (!keyframe) {
+		xor_delta(rewind->scratch.data, rewind->base.data, &rewind->decode_prediction, true);
+	}
+	read_state(rewind->scratch.data, rewind->base.data);
+
+	// Deltas recorded from here on would be against a state the ring no
+	// longer describes, so start a new keyframe.
+	rewind->force_keyframe = true;
+	return true;
+}
+
+void emp_rewind_pop(emp_rewind_t* rewind)
+{
+	if (rewind->count == 0) {
+		return;
+	}
+	rewind->head = (rewind->head - 1) & (rewind->capacity - 1);
+	wait_for_slot(rewind, rewind->head);
+	emp_snapshot_t* snapshot = &rewind->ring[rewind->head];
+	SDL_free(snapshot->data.data);
+	SDL_zerop(snapshot);
+	rewind->count--;
+}
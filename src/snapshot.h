@@ -0,0 +1,104 @@
+#pragma once
+
+#include <Empire/types.h>
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_thread.h>
+
+// Captures the simulation state (update args, players, pooled entities,
+// bullets and tile health) into a compressed buffer the caller frees.
+// These are self-contained keyframes.
+emp_compressed_buffer write_game_snapshot(void);
+void restore_game_snapshot(emp_compressed_buffer compressed_buffer);
+
+typedef struct emp_snapshot_t
+{
+	emp_compressed_buffer data;
+	u64 serial;
+	// Equal to `serial` for keyframes; deltas name the keyframe they XOR against.
+	u64 keyframe_serial;
+	u32 keyframe_slot;
+	// Set while the worker is still compressing into `data`.
+	bool pending;
+} emp_snapshot_t;
+
+typedef struct emp_rewind_job_t
+{
+	u32 slot;
+	u32 staging;
+	bool keyframe;
+} emp_rewind_job_t;
+
+// Scratch for predicting bullets from a keyframe: the integrated streams
+// (x, y, vx, vy, life) and each bullet's dense position in the keyframe.
+typedef struct emp_bullet_prediction_t
+{
+	float* streams[5];
+	u32* base_at;
+	u32 capacity;
+} emp_bullet_prediction_t;
+
+// Ring of rewind snapshots. Every `keyframe_interval` records a full
+// keyframe is taken; the records in between are deltas holding the state
+// XORed against that keyframe plus only the tile-health chunks changed since
+// it, so they compress to a fraction of a keyframe.
+// Bullets are XORed against where their keyframe copy would have flown to,
+// so the bulk of a busy frame codes to zeros.
+// A delta whose keyframe has been overwritten can no longer be restored.
+//
+// Recording only copies the state, and the health chunks flagged in
+// emp_level_t::health_dirty since the last record, into one of two staging
+// buffers on the calling thread. The worker keeps the whole health grid,
+// codes against the keyframe and runs LZ4, then publishes into the ring. Restoring or popping waits only when the
+// slot it needs is still pending.
+typedef struct emp_rewind_t
+{
+	emp_snapshot_t* ring;
+	u32 capacity;
+	u32 head;
+	u32 count;
+	u64 next_serial;
+	u32 keyframe_interval;
+	u32 since_keyframe;
+	bool force_keyframe;
+
+	u64 keyframe_serial;
+	u32 keyframe_slot;
+
+	// Uncompressed keyframe that restored deltas are applied to.
+	emp_buffer base;
+	u64 base_serial;
+	u32 base_slot;
+	emp_buffer scratch;
+	emp_bullet_prediction_t decode_prediction;
+
+	// Owned by the worker: the keyframe new deltas are coded against, the
+	// health grid as of the last staged record and the chunks of it that
+	// changed since the keyframe.
+	emp_buffer keyframe;
+	emp_buffer record;
+	emp_bullet_prediction_t encode_prediction;
+	struct emp_tile_health_t* health;
+	u64* health_changed;
+
+	// Guarded by `lock`: staging ownership, the job queue and ring `pending`.
+	emp_buffer staging[2];
+	bool staging_busy[2];
+	emp_rewind_job_t jobs[2];
+	u32 job_count;
+	bool quit;
+	SDL_Thread* worker;
+	SDL_Mutex* lock;
+	SDL_Condition* wake;
+	SDL_Condition* done;
+} emp_rewind_t;
+
+// `capacity` must be a power of two.
+void emp_rewind_init(emp_rewind_t* rewind, u32 capacity, u32 keyframe_interval);
+void emp_rewind_destroy(emp_rewind_t* rewind);
+void emp_rewind_record(emp_rewind_t* rewind);
+// Restores the newest snapshot without removing it. Returns false when the
+// ring is empty or the snapshot's keyframe is gone.
+bool emp_rewind_restore_latest(emp_rewind_t* rewind);
+void emp_rewind_pop(emp_rewind_t* rewind);
+// Blocks until every recorded snapshot has been compressed.
+void emp_rewind_flush(emp_rewind_t* rewind);
@@ -0,0 +1,127 @@
+#include <Empire/spatial_hash.h>
+#include <SDL3/SDL.h>
+
+static inline u32 cell_hash(i32 cx, i32 cy)
+{
+	return ((u32)cx * 0x8da6b343u) ^ ((u32)cy * 0xd8163841u);
+}
+
+static inline i32 cell_coord(const emp_spatial_hash_t* hash, float v)
+{
+	return (i32)SDL_floorf(v * hash->inv_cell_size);
+}
+
+void emp_spatial_hash_init(emp_spatial_hash_t* hash, float cell_size)
+{
+	SDL_zerop(hash);
+	hash->cell_size = cell_size;
+	hash->inv_cell_size = 1.0f / cell_size;
+}
+
+void emp_spatial_hash_destroy(emp_spatial_hash_t* hash)
+{
+	SDL_free(hash->pending);
+	SDL_free(hash->entries);
+	SDL_free(hash->buckets);
+	SDL_zerop(hash);
+}
+
+void emp_spatial_hash_clear(emp_spatial_hash_t* hash)
+{
+	hash->count = 0;
+	hash->built = false;
+}
+
+void emp_spatial_hash_insert(emp_spatial_hash_t* hash, emp_vec2_t pos, float radius, u32 id)
+{
+	i32 x0 = cell_coord(hash, pos.x - radius);
+	i32 y0 = cell_coord(hash, pos.y - radius);
+	i32 x1 = cell_coord(hash, pos.x + radius);
+	i32 y1 = cell_coord(hash, pos.y + radius);
+
+	for (i32 cy = y0; cy <= y1; ++cy) {
+		for (i32 cx = x0; cx <= x1; ++cx) {
+			if (hash->count == hash->capacity) {
+				hash->capacity = hash->capacity ? hash->capacity * 2 : 256;
+				hash->pending = SDL_realloc(hash->pending, sizeof(emp_spatial_entry_t) * hash->capacity);
+				hash->entries = SDL_realloc(hash->entries, sizeof(emp_spatial_entry_t) * hash->capacity);
+			}
+			hash->pending[hash->count++] = (emp_spatial_entry_t) { .cx = cx, .cy = cy, .id = id };
+		}
+	}
+	hash->built = false;
+}
+
+void emp_spatial_hash_build(emp_spatial_hash_t* hash)
+{
+	// Roughly two buckets per entry keeps chains short without the table
+	// outgrowing the entries.
+	u32 bucket_count = 64;
+	while (bucket_count < hash->count * 2) {
+		bucket_count *= 2;
+	}
+	if (bucket_count + 1 > hash->bucket_capacity) {
+		hash->bucket_capacity = bucket_count + 1;
+		hash->buckets = SDL_realloc(hash->buckets, sizeof(u32) * hash->bucket_capacity);
+	}
+	hash->bucket_mask = bucket_count - 1;
+
+	u32* buckets = hash->buckets;
+	SDL_memset(buckets, 0, sizeof(u32) * (bucket_count + 1));
+
+	for (u32 i = 0; i < hash->count; ++i) {
+		emp_spatial_entry_t* e = &hash->pending[i];
+		buckets[(cell_hash(e->cx, e->cy) & hash->bucket_mask) + 1]++;
+	}
+	for (u32 b = 1; b <= bucket_count; ++b) {
+		buckets[b] += buckets[b - 1];
+	}
+	for (u32 i = 0; i < hash->count; ++i) {
+		emp_spatial_entry_t* e = &hash->pending[i];
+		hash->entries[buckets[cell_hash(e->cx, e->cy) & hash->bucket_mask]++] = *e;
+	}
+	// The scatter advanced every start to the next bucket's; shift back.
+	for (u32 b = bucket_count; b > 0; --b) {
+		buckets[b] = buckets[b - 1];
+	}
+	buckets[0] = 0;
+	hash->built = true;
+}
+
+u32 emp_spatial_hash_query(const emp_spatial_hash_t* hash, emp_vec2_t pos, u32* out, u32 max)
+{
+	if (!hash->built || hash->count == 0) {
+		return 0;
+	}
+
+	u32 found = 0;
+	i32 px = cell_coord(hash, pos.x);
+	i32 py = cell_coord(hash, pos.y);
+
+	for (i32 cy = py - 1; cy <= py + 1; ++cy) {
+		for (i32 cx = px - 1; cx <= px + 1; ++cx) {
+			u32 b = cell_hash(cx, cy) & hash->bucket_mask;
+			for (u32 i = hash->buckets[b]; i < hash->buckets[b + 1]; ++i) {
+				const emp_spatial_entry_t* e = &hash->entries[i];
+				if (e->cx != cx || e->cy != cy) {
+					continue;
+				}
+
+				bool seen = false;
+				for (u32 j = 0; j < found; ++j) {
+					if (out[j] == e->id) {
+						seen = true;
+						break;
+					}
+				}
+				if (!seen) {
+					if (found == max) {
+						return found;
+					}
+					out[found++] = e->id;
+				}
+			}
+		}
+	}
+	return found;
+}
@@ -0,0 +1,190 @@
+#include <Empire/sprite_batch.h>
+#include <SDL3/SDL.h>
+
+#define EMP_SPRITE_BATCH_INITIAL_CAPACITY 4096
+
+static void grow_sprites(emp_sprite_batch_t* batch)
+{
+	u32 capacity = batch->capacity ? batch->capacity * 2 : EMP_SPRITE_BATCH_INITIAL_CAPACITY;
+	batch->sprites = SDL_realloc(batch->sprites, sizeof(emp_sprite_t) * capacity);
+	batch->order = SDL_realloc(batch->order, sizeof(u32) * capacity);
+	batch->vertices = SDL_realloc(batch->vertices, sizeof(SDL_Vertex) * 4 * capacity);
+	batch->indices = SDL_realloc(batch->indices, sizeof(int) * 6 * capacity);
+
+	// Every run is submitted from vertex 0 of its own range, so the index
+	// pattern is the same for all quads and only has to be written once.
+	for (u32 i = batch->capacity; i < capacity; ++i) {
+		int v = (int)i * 4;
+		int* idx = batch->indices + i * 6;
+		idx[0] = v + 0;
+		idx[1] = v + 1;
+		idx[2] = v + 2;
+		idx[3] = v + 2;
+		idx[4] = v + 3;
+		idx[5] = v + 0;
+	}
+	batch->capacity = capacity;
+}
+
+static u32 texture_slot(emp_sprite_batch_t* batch, SDL_Texture* texture)
+{
+	if (batch->last_texture < batch->texture_count && batch->textures[batch->last_texture].texture == texture) {
+		return batch->last_texture;
+	}
+
+	for (u32 i = 0; i < batch->texture_count; ++i) {
+		if (batch->textures[i].texture == texture) {
+			batch->last_texture = i;
+			return i;
+		}
+	}
+
+	if (batch->texture_count == batch->texture_capacity) {
+		batch->texture_capacity = batch->texture_capacity ? batch->texture_capacity * 2 : 32;
+		batch->textures = SDL_realloc(batch->textures, sizeof(emp_sprite_texture_t) * batch->texture_capacity);
+	}
+
+	float w = 1.0f, h = 1.0f;
+	SDL_GetTextureSize(texture, &w, &h);
+
+	u32 slot = batch->texture_count++;
+	batch->textures[slot] = (emp_sprite_texture_t) {
+		.texture = texture,
+		.inv_width = 1.0f / w,
+		.inv_height = 1.0f / h,
+	};
+	batch->last_texture = slot;
+	return slot;
+}
+
+void emp_sprite_batch_init(emp_sprite_batch_t* batch, u32 layer_count)
+{
+	SDL_zerop(batch);
+	batch->layer_count = layer_count;
+	grow_sprites(batch);
+}
+
+void emp_sprite_batch_destroy(emp_sprite_batch_t* batch)
+{
+	SDL_free(batch->sprites);
+	SDL_free(batch->order);
+	SDL_free(batch->textures);
+	SDL_free(batch->buckets);
+	SDL_free(batch->vertices);
+	SDL_free(batch->indices);
+	SDL_zerop(batch);
+}
+
+void emp_sprite_batch_draw(emp_sprite_batch_t* batch, u32 layer, SDL_Texture* texture, const SDL_FRect* src, const SDL_FRect* dst, SDL_FColor color)
+{
+	SDL_assert(layer < batch->layer_count);
+	if (!texture) {
+		return;
+	}
+
+	if (batch->count == batch->capacity) {
+		grow_sprites(batch);
+	}
+
+	u32 slot = texture_slot(batch, texture);
+	emp_sprite_texture_t* tex = &batch->textures[slot];
+
+	emp_sprite_t* sprite = &batch->sprites[batch->count++];
+	sprite->x0 = dst->x;
+	sprite->y0 = dst->y;
+	sprite->x1 = dst->x + dst->w;
+	sprite->y1 = dst->y + dst->h;
+	if (src) {
+		sprite->u0 = src->x * tex->inv_width;
+		sprite->v0 = src->y * tex->inv_height;
+		sprite->u1 = (src->x + src->w) * tex->inv_width;
+		sprite->v1 = (src->y + src->h) * tex->inv_height;
+	} else {
+		sprite->u0 = 0.0f;
+		sprite->v0 = 0.0f;
+		sprite->u1 = 1.0f;
+		sprite->v1 = 1.0f;
+	}
+	sprite->color = color;
+	sprite->layer = layer;
+	sprite->texture = slot;
+}
+
+emp_sprite_t* emp_sprite_batch_reserve(emp_sprite_batch_t* batch, u32 layer, SDL_Texture* texture, u32 count, SDL_FColor color)
+{
+	SDL_assert(layer < batch->layer_count);
+	if (!texture) {
+		return NULL;
+	}
+
+	while (batch->count + count > batch->capacity) {
+		grow_sprites(batch);
+	}
+
+	u32 slot = texture_slot(batch, texture);
+	emp_sprite_t* sprites = &batch->sprites[batch->count];
+	for (u32 i = 0; i < count; ++i) {
+		sprites[i].color = color;
+		sprites[i].layer = layer;
+		sprites[i].texture = slot;
+	}
+	batch->count += count;
+	return sprites;
+}
+
+void emp_sprite_batch_flush(emp_sprite_batch_t* batch, SDL_Renderer* renderer)
+{
+	batch->draw_calls = 0;
+	if (batch->count == 0) {
+		batch->texture_count = 0;
+		return;
+	}
+
+	// Counting sort on the layer alone; stable, so sprites overlap inside a
+	// layer in the order they were submitted. Runs break where the texture
+	// changes, which the atlas pages keep rare.
+	if (batch->layer_count + 1 > batch->bucket_capacity) {
+		batch->bucket_capacity = batch->layer_count + 1;
+		batch->buckets = SDL_realloc(batch->buckets, sizeof(u32) * batch->bucket_capacity);
+	}
+	SDL_memset(batch->buckets, 0, sizeof(u32) * (batch->layer_count + 1));
+
+	for (u32 i = 0; i < batch->count; ++i) {
+		batch->buckets[batch->sprites[i].layer + 1]++;
+	}
+	for (u32 i = 1; i <= batch->layer_count; ++i) {
+		batch->buckets[i] += batch->buckets[i - 1];
+	}
+	for (u32 i = 0; i < batch->count; ++i) {
+		batch->order[batch->buckets[batch->sprites[i].layer]++] = i;
+	}
+
+	SDL_Vertex* v = batch->vertices;
+	for (u32 i = 0; i < batch->count; ++i) {
+		emp_sprite_t* s = &batch->sprites[batch->order[i]];
+		v[0] = (SDL_Vertex) { { s->x0, s->y0 }, s->color, { s->u0, s->v0 } };
+		v[1] = (SDL_Vertex) { { s->x1, s->y0 }, s->color, { s->u1, s->v0 } };
+		v[2] = (SDL_Vertex) { { s->x1, s->y1 }, s->color, { s->u1, s->v1 } };
+		v[3] = (SDL_Vertex) { { s->x0, s->y1 }, s->color, { s->u0, s->v1 } };
+		v += 4;
+	}
+
+	u32 run_start = 0;
+	for (u32 i = 1; i <= batch->count; ++i) {
+		emp_sprite_t* first = &batch->sprites[batch->order[run_start]];
+		if (i < batch->count) {
+			emp_sprite_t* s = &batch->sprites[batch->order[i]];
+			if (s->texture == first->texture && s->layer == first->layer) {
+				continue;
+			}
+		}
+
+		u32 quads = i - run_start;
+		SDL_RenderGeometry(renderer, batch->textures[first->texture].texture, batch->vertices + run_start * 4, (int)quads * 4, batch->indices, (int)quads * 6);
+		batch->draw_calls++;
+		run_start = i;
+	}
+
+	batch->count = 0;
+	batch->texture_count = 0;
+}
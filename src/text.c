@@ -1,3 +1,6 @@
+#include <Empire/hash.inl>
+#include <Empire/package.h>
+#include <Empire/stb_ds.h>
 #include <Empire/text.h>
 #include <Empire/util.h>
 #include "entities.h" // G
@@ -5,13 +8,23 @@
 #include <SDL3/SDL.h>
 
 
+#define FONT_ATLAS_SIZE 512
+
+static emp_text_quad_t glyph_quad(emp_font_t* font, char c, float* x, float* y) {
+    stbtt_aligned_quad q;
+    stbtt_GetBakedQuad(font->cdata, FONT_ATLAS_SIZE, FONT_ATLAS_SIZE, c - 32, x, y, &q, 1);
+    return (emp_text_quad_t) { q.x0, q.y0, q.x1, q.y1, q.s0, q.t0, q.s1, q.t1 };
+}
+
 void emp_load_font(SDL_Renderer* renderer, emp_asset_t* font_asset, float size) {
-    emp_font_t* f = SDL_malloc(sizeof(emp_font_t));
+    emp_font_t* f = SDL_calloc(1, sizeof(emp_font_t));
     f->size = size;
 
+	// Fonts have no loader, so nothing has decompressed them from the package yet.
+	emp_package_load(font_asset);
 	emp_buffer ttf_buffer = font_asset->data;
 
-    int w = 512, h = 512;
+    int w = FONT_ATLAS_SIZE, h = FONT_ATLAS_SIZE;
     unsigned char* alpha_bitmap = SDL_malloc(w * h);
     stbtt_BakeFontBitmap(ttf_buffer.data, 0, size, alpha_bitmap, w, h, 32, 96, f->cdata);
 
@@ -29,35 +42,106 @@ void emp_load_font(SDL_Renderer* renderer, emp_asset_t* font_asset, float size)
 
     SDL_free(alpha_bitmap);
     SDL_free(pixels);
+
+    for (int d = 0; d < 10; d++) {
+        float x = 0.0f, y = 0.0f;
+        f->digits[d] = glyph_quad(f, (char)('0' + d), &x, &y);
+        f->digit_advance[d] = x;
+    }
 	font_asset->handle = f;
 }
 
-void emp_draw_text(float x, float y, const char* text, u8 r, u8 g, u8 b, emp_asset_t* font_asset) {
-	emp_font_t* font = font_asset->handle;
-	SDL_Renderer* renderer = G->renderer;
-	SDL_SetTextureColorMod(font->texture, r, g, b); 
+static void clear_layouts(emp_font_t* font) {
+    for (ptrdiff_t i = 0; i < hmlen(font->layouts); i++) {
+        SDL_free(font->layouts[i].value.quads);
+        SDL_free(font->layouts[i].value.text);
+    }
+    hmfree(font->layouts);
+}
 
-    while (*text) {
-        if (*text >= 32 && *text <= 126) {
-            stbtt_aligned_quad q;
-            stbtt_GetBakedQuad(font->cdata, 512, 512, *text - 32, &x, &y, &q, 1);
+static emp_text_layout_t layout_text(emp_font_t* font, const char* text) {
+    emp_text_layout_t layout = { 0 };
+    layout.text = SDL_strdup(text);
+    layout.quads = SDL_malloc(sizeof(emp_text_quad_t) * (SDL_strlen(text) + 1));
+    float x = 0.0f, y = 0.0f;
+    for (const char* c = text; *c; c++) {
+        if (*c >= 32 && *c <= 126) {
+            layout.quads[layout.count++] = glyph_quad(font, *c, &x, &y);
+        }
+    }
+    return layout;
+}
 
-            SDL_FRect src = {
-                .x = q.s0 * 512.0f, 
-                .y = q.t0 * 512.0f, 
-                .w = (q.s1 - q.s0) * 512.0f, 
-                .h = (q.t1 - q.t0) * 512.0f
-            };
+static emp_text_layout_t* find_layout(emp_font_t* font, const char* text) {
+    u64 key = hash_str(text);
+    emp_text_layout_kvp* pair = hmgetp_null(font->layouts, key);
+    if (pair && SDL_strcmp(pair->value.text, text) == 0) {
+        return &pair->value;
+    }
+    // Another string with the same hash gives up its slot.
+    if (pair) {
+        SDL_free(pair->value.quads);
+        SDL_free(pair->value.text);
+        pair->value = layout_text(font, text);
+        return &pair->value;
+    }
 
-            SDL_FRect dst = {
-                .x = q.x0, 
-                .y = q.y0, 
-                .w = q.x1 - q.x0, 
-                .h = q.y1 - q.y0
-            };
+    // Strings that change every frame would grow the cache without bound.
+    if (hmlen(font->layouts) >= EMP_TEXT_CACHE_CAPACITY) {
+        clear_layouts(font);
+    }
 
-            SDL_RenderTexture(renderer, font->texture, &src, &dst);
-        }
-        text++;
+    hmput(font->layouts, key, layout_text(font, text));
+    return &hmgetp(font->layouts, key)->value;
+}
+
+// Glyph positions are rounded to whole pixels, as stb_truetype does.
+static void emit_quads(emp_font_t* font, float x, float y, const emp_text_quad_t* quads, u32 count, SDL_FColor color, u32 layer) {
+    emp_sprite_t* sprites = emp_sprite_batch_reserve(G->sprites, layer, font->texture, count, color);
+    if (!sprites) {
+        return;
+    }
+    x = SDL_floorf(x + 0.5f);
+    y = SDL_floorf(y + 0.5f);
+    for (u32 i = 0; i < count; i++) {
+        const emp_text_quad_t* q = &quads[i];
+        emp_sprite_t* s = &sprites[i];
+        s->x0 = x + q->x0;
+        s->y0 = y + q->y0;
+        s->x1 = x + q->x1;
+        s->y1 = y + q->y1;
+        s->u0 = q->u0;
+        s->v0 = q->v0;
+        s->u1 = q->u1;
+        s->v1 = q->v1;
+    }
+}
+
+void emp_draw_text(float x, float y, const char* text, u8 r, u8 g, u8 b, emp_asset_t* font_asset, u32 layer) {
+    emp_font_t* font = font_asset->handle;
+    emp_text_layout_t* layout = find_layout(font, text);
+    emit_quads(font, x, y, layout->quads, layout->count, emp_sprite_color(r, g, b, 255), layer);
+}
+
+void emp_draw_number(float x, float y, u32 number, u8 r, u8 g, u8 b, emp_asset_t* font_asset, u32 layer) {
+    emp_font_t* font = font_asset->handle;
+
+    u32 digits[10];
+    u32 count = 0;
+    do {
+        digits[count++] = number % 10;
+        number /= 10;
+    } while (number > 0);
+
+    emp_text_quad_t quads[10];
+    float pen = 0.0f;
+    for (u32 i = 0; i < count; i++) {
+        u32 d = digits[count - 1 - i];
+        float offset = SDL_floorf(pen + 0.5f);
+        quads[i] = font->digits[d];
+        quads[i].x0 += offset;
+        quads[i].x1 += offset;
+        pen += font->digit_advance[d];
     }
-}
\ No newline at end of file
+    emit_quads(font, x, y, quads, count, emp_sprite_color(r, g, b, 255), layer);
+}